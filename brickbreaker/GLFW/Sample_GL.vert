@@ -3,8 +3,14 @@
 // input data : sent from main program
 layout (location = 0) in vec3 vertexPosition;
 layout (location = 1) in vec3 vertexColor;
+layout (location = 2) in vec3 brickInstance; // x, y, type; one per brick
 
-uniform mat4 MVP;
+layout (std140) uniform Camera {
+    mat4 VP;               // only rewritten when the camera moves
+};
+uniform vec4 Placement;    // x, y offset, rotation in radians, scale
+uniform bool Instanced;    // drawing the brick batch
+uniform vec3 Palette[3];   // brick colours, indexed by type
 
 // output data : used by fragment shader
 out vec3 fragColor;
@@ -17,6 +23,16 @@ void main ()
     // to produce the color of each fragment
     fragColor = vertexColor;
 
-    // Output position of the vertex, in clip space : MVP * position
-    gl_Position = MVP * v;
+    // Bricks are moved to their place here instead of by a model matrix
+    if (Instanced) {
+        v.xy += brickInstance.xy;
+        fragColor = Palette[int(brickInstance.z)];
+    }
+
+    // Scale, turn and move the object in place; this is the model matrix
+    float c = cos(Placement.z), s = sin(Placement.z);
+    v.xy = mat2(c, s, -s, c) * (v.xy * Placement.w) + Placement.xy;
+
+    // Output position of the vertex, in clip space : VP * position
+    gl_Position = VP * v;
 }
@@ -3,6 +3,11 @@
 #include <fstream>
 #include <vector>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <chrono>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -10,7 +15,25 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-void draw(GLFWwindow*) ;
+
+#include "game.h"
+#include "governor.h"
+#include "spritebatch.h"
+#include "scorewidget.h"
+#include "textbatch.h"
+#include "glstate.h"
+#include "camera.h"
+#include "shadermanager.h"
+#include "assets.h"
+#include "renderqueue.h"
+#include "headless.h"
+#include "capture.h"
+#include "profiler.h"
+#include "trace.h"
+#include "renderstats.h"
+#include "histogram.h"
+#include "rendertarget.h"
+void update(GLFWwindow*, RenderFrame*) ;
 using namespace std;
 
 void handleKeypress(unsigned char key , int x, int y){
@@ -21,100 +44,68 @@ switch (key){
 }
 struct VAO {
     GLuint VertexArrayID;
-    GLuint VertexBuffer;
-    GLuint ColorBuffer;
+    GLuint VertexBuffer; // interleaved: x, y, then r, g, b, a unless the object has one colour
 
     GLenum PrimitiveMode;
     GLenum FillMode;
     int NumVertices;
+
+    GLenum PositionType; // GL_HALF_FLOAT, or GL_FLOAT where half loses too much
+    GLsizei Stride;
+    bool UniformColor;   // Color is set as a constant attribute at draw time
+    GLfloat Color[3];
+    GLfloat Bounds[4];   // min x, min y, max x, max y; what the sprite batch draws
+    GLfloat Radius;      // of the circle round the origin holding Bounds, turned any way
 };
 typedef struct VAO VAO;
 
 struct GLMatrices {
-	glm::mat4 projection;
-	glm::mat4 model;
-	glm::mat4 view;
-	GLuint MatrixID;
+	GLuint PlacementID; // offset, rotation and scale of the object drawn
+	GLuint InstancedID; // set while drawing the brick batch
+	GLuint PaletteID;
 } Matrices;
 
 GLuint programID;
-
-/* Function to load Shaders - Use it as it is */
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path) {
-
-	// Create the shaders
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
-
-	// Read the Vertex Shader code from the file
-	std::string VertexShaderCode;
-	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-	if(VertexShaderStream.is_open())
-	{
-		std::string Line = "";
-		while(getline(VertexShaderStream, Line))
-			VertexShaderCode += "\n" + Line;
-		VertexShaderStream.close();
-	}
-
-	// Read the Fragment Shader code from the file
-	std::string FragmentShaderCode;
-	std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-	if(FragmentShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(FragmentShaderStream, Line))
-			FragmentShaderCode += "\n" + Line;
-		FragmentShaderStream.close();
-	}
-
-	GLint Result = GL_FALSE;
-	int InfoLogLength;
-
-	// Compile Vertex Shader
-	printf("Compiling shader : %s\n", vertex_file_path);
-	char const * VertexSourcePointer = VertexShaderCode.c_str();
-	glShaderSource(VertexShaderID, 1, &VertexSourcePointer , NULL);
-	glCompileShader(VertexShaderID);
-
-	// Check Vertex Shader
-	glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	std::vector<char> VertexShaderErrorMessage(InfoLogLength);
-	glGetShaderInfoLog(VertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
-	fprintf(stdout, "%s\n", &VertexShaderErrorMessage[0]);
-
-	// Compile Fragment Shader
-	printf("Compiling shader : %s\n", fragment_file_path);
-	char const * FragmentSourcePointer = FragmentShaderCode.c_str();
-	glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer , NULL);
-	glCompileShader(FragmentShaderID);
-
-	// Check Fragment Shader
-	glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	std::vector<char> FragmentShaderErrorMessage(InfoLogLength);
-	glGetShaderInfoLog(FragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
-	fprintf(stdout, "%s\n", &FragmentShaderErrorMessage[0]);
-
-	// Link the program
-	fprintf(stdout, "Linking program\n");
-	GLuint ProgramID = glCreateProgram();
-	glAttachShader(ProgramID, VertexShaderID);
-	glAttachShader(ProgramID, FragmentShaderID);
-	glLinkProgram(ProgramID);
-
-	// Check the program
-	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
-	glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	std::vector<char> ProgramErrorMessage( max(InfoLogLength, int(1)) );
-	glGetProgramInfoLog(ProgramID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
-	fprintf(stdout, "%s\n", &ProgramErrorMessage[0]);
-
-	glDeleteShader(VertexShaderID);
-	glDeleteShader(FragmentShaderID);
-
-	return ProgramID;
+GLuint spriteprogramID;
+SpriteBatch sprites;
+bool batching = true; // 'b' switches back to drawing every object on its own
+ScoreWidget scoreboard;
+TextBatch hudtext;
+bool debughud = false; // 'h' adds the debug counters to the HUD
+int hudwidth, hudheight; // framebuffer size; the HUD is laid out in pixels
+glm::mat4 hudprojection;
+Camera camera; // view-projection, shared by the world programs
+CameraView view; // where the keys have moved the camera
+RenderQueue renderqueue; // frames on their way to the render thread
+int framewidth, frameheight; // framebuffer size as last reported by GLFW
+bool headless = false; // --headless: an EGL context and a framebuffer object, no window
+const char* shotpath = NULL; // --shot: the last headless frame is saved here
+const char* capturepath = NULL; // --capture: every frame is recorded here
+Capture capture;
+
+/* Parts of a frame timed by the profiler, 'o' shows them */
+enum DrawScope { SCOPE_MIRRORS, SCOPE_BASKETS, SCOPE_CANNON, SCOPE_LASER, SCOPE_BRICKS, SCOPE_LINE,
+	SCOPE_SPRITES, SCOPE_SCORE, SCOPE_HUD, NSCOPES };
+const char* const scopenames[NSCOPES] = { "MIRRORS", "BASKETS", "CANNON", "LASER", "BRICKS", "LINE",
+	"SPRITES", "SCORE", "HUD" };
+Profiler profiler;
+bool profiling = false;
+FrameTimer frametimer; // GPU time per frame, for the load governor
+RenderTarget rendertarget; // where the world is drawn at a lower resolution
+
+// times of every frame, kept by the render thread; 'l' prints them
+TimeHistogram frametimes, simtimes, rendertimes, presenttimes;
+bool reporttimes = false;
+
+/* Seconds since the first call. Not glfwGetTime, which needs GLFW started,
+ * and a headless run never starts it. */
+double clockTime ()
+{
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
+double frametime; // smoothed time from one frame to the next
+bool linked; // programID is set up on its first use, see shadermanager.h
 
 static void error_callback(int error, const char* description)
 {
@@ -123,86 +114,247 @@ static void error_callback(int error, const char* description)
 
 void quit(GLFWwindow *window)
 {
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    // the render thread may be drawing into the window; main() closes it
+    // once that thread is done
+    glfwSetWindowShouldClose(window, GL_TRUE);
 //    exit(EXIT_SUCCESS);
 }
 
 
-/* Generate VAO, VBOs and return VAO handle */
-struct VAO* create3DObject (GLenum primitive_mode, int numVertices, const GLfloat* vertex_buffer_data, const GLfloat* color_buffer_data, GLenum fill_mode=GL_FILL)
+/* A 0..1 colour channel as a normalized byte, rounded to the nearest step */
+GLubyte colorByte (float f)
+{
+    return (GLubyte)(f*255 + 0.5f);
+}
+
+/* IEEE half precision, tiny values flushed to zero */
+GLushort floatToHalf (float f)
+{
+    unsigned int x;
+    memcpy(&x, &f, sizeof x);
+    unsigned int sign = (x >> 16) & 0x8000;
+    int exp = (int)((x >> 23) & 0xff) - 127 + 15;
+    unsigned int mant = x & 0x7fffff;
+    if (exp <= 0)
+        return sign;
+    if (exp >= 31)
+        return sign | 0x7c00;
+    unsigned int h = sign | (exp << 10) | (mant >> 13);
+    if (mant & 0x1000) // round to nearest
+        h++;
+    return h;
+}
+
+float halfToFloat (GLushort h)
+{
+    unsigned int exp = (h >> 10) & 0x1f;
+    unsigned int x = (unsigned int)(h & 0x8000) << 16;
+    if (exp != 0)
+        x |= ((exp - 15 + 127) << 23) | ((unsigned int)(h & 0x3ff) << 13);
+    float f;
+    memcpy(&f, &x, sizeof f);
+    return f;
+}
+
+/* Generate VAO and one interleaved VBO and return VAO handle.
+ * Only x and y are stored since the scene is flat, as half floats when that
+ * keeps them within 1/1000 of a unit, and colours as normalized bytes. An
+ * object with a single colour stores no colour at all. */
+struct VAO* createPackedObject (GLenum primitive_mode, int numVertices, const GLfloat* vertex_buffer_data, const GLfloat* color_buffer_data, const GLfloat* color, GLenum fill_mode)
 {
     struct VAO* vao = new struct VAO;
     vao->PrimitiveMode = primitive_mode;
     vao->NumVertices = numVertices;
     vao->FillMode = fill_mode;
 
+    vao->PositionType = GL_HALF_FLOAT;
+    for (int i=0; i<2*numVertices; i++) {
+        float v = vertex_buffer_data[3*(i/2) + i%2];
+        if (fabs(halfToFloat(floatToHalf(v)) - v) > 0.001)
+            vao->PositionType = GL_FLOAT;
+    }
+    int possize = vao->PositionType == GL_HALF_FLOAT ? 2*sizeof(GLushort) : 2*sizeof(GLfloat);
+
+    vao->Bounds[0] = vao->Bounds[2] = vertex_buffer_data[0];
+    vao->Bounds[1] = vao->Bounds[3] = vertex_buffer_data[1];
+    for (int i=1; i<numVertices; i++) {
+        vao->Bounds[0] = min(vao->Bounds[0], vertex_buffer_data[3*i]);
+        vao->Bounds[1] = min(vao->Bounds[1], vertex_buffer_data[3*i + 1]);
+        vao->Bounds[2] = max(vao->Bounds[2], vertex_buffer_data[3*i]);
+        vao->Bounds[3] = max(vao->Bounds[3], vertex_buffer_data[3*i + 1]);
+    }
+    vao->Radius = 0;
+    for (int i=0; i<numVertices; i++)
+        vao->Radius = max(vao->Radius, (GLfloat)hypot(vertex_buffer_data[3*i], vertex_buffer_data[3*i + 1]));
+
+    vao->UniformColor = color != NULL;
+    if (vao->UniformColor)
+        memcpy(vao->Color, color, sizeof vao->Color);
+    vao->Stride = possize + (vao->UniformColor ? 0 : 4);
+
+    std::vector<unsigned char> data(vao->Stride*numVertices);
+    for (int i=0; i<numVertices; i++) {
+        unsigned char* v = &data[i*vao->Stride];
+        if (vao->PositionType == GL_HALF_FLOAT) {
+            GLushort p[2] = { floatToHalf(vertex_buffer_data[3*i]), floatToHalf(vertex_buffer_data[3*i + 1]) };
+            memcpy(v, p, sizeof p);
+        }
+        else
+            memcpy(v, &vertex_buffer_data[3*i], 2*sizeof(GLfloat));
+        if (!vao->UniformColor) {
+            for (int c=0; c<3; c++)
+                v[possize + c] = colorByte(color_buffer_data[3*i + c]);
+            v[possize + 3] = 255;
+        }
+    }
+
     // Create Vertex Array Object
     // Should be done after CreateWindow and before any other GL calls
     glGenVertexArrays(1, &(vao->VertexArrayID)); // VAO
-    glGenBuffers (1, &(vao->VertexBuffer)); // VBO - vertices
-    glGenBuffers (1, &(vao->ColorBuffer));  // VBO - colors
+    glGenBuffers (1, &(vao->VertexBuffer)); // VBO - vertices and colors
 
-    glBindVertexArray (vao->VertexArrayID); // Bind the VAO
-    glBindBuffer (GL_ARRAY_BUFFER, vao->VertexBuffer); // Bind the VBO vertices
-    glBufferData (GL_ARRAY_BUFFER, 3*numVertices*sizeof(GLfloat), vertex_buffer_data, GL_STATIC_DRAW); // Copy the vertices into VBO
+    bindVertexArray(vao->VertexArrayID); // Bind the VAO
+    bindArrayBuffer(vao->VertexBuffer); // Bind the VBO
+    glBufferData (GL_ARRAY_BUFFER, data.size(), &data[0], GL_STATIC_DRAW); // Copy the vertices into VBO
+    countUpload(data.size());
     glVertexAttribPointer(
                           0,                  // attribute 0. Vertices
-                          3,                  // size (x,y,z)
-                          GL_FLOAT,           // type
+                          2,                  // size (x,y), z defaults to 0
+                          vao->PositionType,  // type
                           GL_FALSE,           // normalized?
-                          0,                  // stride
-                          (void*)0            // array buffer offset
-                          );
-
-    glBindBuffer (GL_ARRAY_BUFFER, vao->ColorBuffer); // Bind the VBO colors
-    glBufferData (GL_ARRAY_BUFFER, 3*numVertices*sizeof(GLfloat), color_buffer_data, GL_STATIC_DRAW);  // Copy the vertex colors
-    glVertexAttribPointer(
-                          1,                  // attribute 1. Color
-                          3,                  // size (r,g,b)
-                          GL_FLOAT,           // type
-                          GL_FALSE,           // normalized?
-                          0,                  // stride
+                          vao->Stride,        // stride
                           (void*)0            // array buffer offset
                           );
+    enableVertexAttrib(0);
+
+    if (!vao->UniformColor) {
+        glVertexAttribPointer(
+                              1,                  // attribute 1. Color
+                              4,                  // size (r,g,b,a)
+                              GL_UNSIGNED_BYTE,   // type
+                              GL_TRUE,            // normalized to 0..1
+                              vao->Stride,        // stride
+                              (void*)(size_t)possize // array buffer offset
+                              );
+        enableVertexAttrib(1);
+    }
 
     return vao;
 }
 
+/* Generate VAO, VBOs and return VAO handle */
+struct VAO* create3DObject (GLenum primitive_mode, int numVertices, const GLfloat* vertex_buffer_data, const GLfloat* color_buffer_data, GLenum fill_mode=GL_FILL)
+{
+    // most objects are painted in one colour, which then needs no per vertex data
+    bool uniform = true;
+    for (int i=3; i<3*numVertices; i++)
+        if (color_buffer_data[i] != color_buffer_data[i%3])
+            uniform = false;
+    return createPackedObject(primitive_mode, numVertices, vertex_buffer_data, color_buffer_data, uniform ? color_buffer_data : NULL, fill_mode);
+}
+
 /* Generate VAO, VBOs and return VAO handle - Common Color for all vertices */
 struct VAO* create3DObject (GLenum primitive_mode, int numVertices, const GLfloat* vertex_buffer_data, const GLfloat red, const GLfloat green, const GLfloat blue, GLenum fill_mode=GL_FILL)
 {
-    GLfloat* color_buffer_data = new GLfloat [3*numVertices];
-    for (int i=0; i<numVertices; i++) {
-        color_buffer_data [3*i] = red;
-        color_buffer_data [3*i + 1] = green;
-        color_buffer_data [3*i + 2] = blue;
-    }
-
-    return create3DObject(primitive_mode, numVertices, vertex_buffer_data, color_buffer_data, fill_mode);
+    GLfloat color[3] = { red, green, blue };
+    return createPackedObject(primitive_mode, numVertices, vertex_buffer_data, NULL, color, fill_mode);
 }
 
 /* Render the VBOs handled by VAO */
 void draw3DObject (struct VAO* vao)
 {
-    // Change the Fill Mode for this object
-    glPolygonMode (GL_FRONT_AND_BACK, vao->FillMode);
+    // Change the Fill Mode for this object; these calls go through the
+    // state cache, so they cost nothing when the last object set the same
+    polygonMode(vao->FillMode);
 
-    // Bind the VAO to use
-    glBindVertexArray (vao->VertexArrayID);
+    // Bind the VAO to use; it remembers the attribute layout
+    bindVertexArray(vao->VertexArrayID);
 
-    // Enable Vertex Attribute 0 - 3d Vertices
-    glEnableVertexAttribArray(0);
-    // Bind the VBO to use
-    glBindBuffer(GL_ARRAY_BUFFER, vao->VertexBuffer);
-
-    // Enable Vertex Attribute 1 - Color
-    glEnableVertexAttribArray(1);
-    // Bind the VBO to use
-    glBindBuffer(GL_ARRAY_BUFFER, vao->ColorBuffer);
+    // Attribute 1 is not an array for a single colour object, so its
+    // current value is used for every vertex
+    if (vao->UniformColor)
+        vertexAttrib3fv(1, vao->Color);
 
     // Draw the geometry !
     glDrawArrays(vao->PrimitiveMode, 0, vao->NumVertices); // Starting from vertex 0; 3 vertices total -> 1 triangle
+    countDraw(vao->NumVertices);
+}
+
+/* Records obj that was at prevx, prevy turned by prevrotation degrees before
+ * the last tick and is at x, y turned by rotation now, for renderObject */
+void drawMovingObject (RenderFrame* frame, int scope, struct VAO* obj, float prevx, float prevy, float prevrotation,
+        float x, float y, float rotation, int layer=0)
+{
+    if (frame->nobjects == RENDER_MAX_OBJECTS)
+        return;
+    RenderObject* r = &frame->objects[frame->nobjects++];
+    r->object = obj;
+    r->x = x;
+    r->y = y;
+    r->rotation = rotation;
+    r->prevx = prevx;
+    r->prevy = prevy;
+    r->prevrotation = prevrotation;
+    r->layer = layer;
+    r->scope = scope;
+}
+
+/* Records obj moved to x, y and turned by rotation degrees, for renderObject */
+void drawObject (RenderFrame* frame, int scope, struct VAO* obj, float x, float y, float rotation, int layer=0)
+{
+    drawMovingObject(frame, scope, obj, x, y, rotation, x, y, rotation, layer);
+}
+
+/* The point alpha of the way from a to b */
+static inline float tween (float a, float b, float alpha)
+{
+    return a + (b - a)*alpha;
+}
+
+GLfloat viewrect[4]; // the world the camera shows this frame, set by render()
+
+/* Whether obj placed at x, y can be in view at all. A turned object is
+ * taken as the circle round it, which holds it at any angle. */
+static inline bool inView (const struct VAO* obj, float x, float y, bool turned)
+{
+    if (turned)
+        return x + obj->Radius >= viewrect[0] && x - obj->Radius <= viewrect[2] &&
+            y + obj->Radius >= viewrect[1] && y - obj->Radius <= viewrect[3];
+    return x + obj->Bounds[2] >= viewrect[0] && x + obj->Bounds[0] <= viewrect[2] &&
+        y + obj->Bounds[3] >= viewrect[1] && y + obj->Bounds[1] <= viewrect[3];
+}
+
+/* Draws a recorded object where it is between the last two ticks, unless
+ * it is out of view. With batching on, a single colour object only becomes
+ * a sprite, drawn when the frame is flushed */
+void renderObject (const RenderFrame* frame, const RenderObject* r)
+{
+    struct VAO* obj = r->object;
+    float x = tween(r->prevx, r->x, frame->alpha);
+    float y = tween(r->prevy, r->y, frame->alpha);
+    float rotation = tween(r->prevrotation, r->rotation, frame->alpha);
+    if (!inView(obj, x, y, rotation != 0)) {
+        countStat(STAT_CULLED);
+        return;
+    }
+    if (frame->batching && obj->UniformColor) {
+        SpriteInstance s;
+        s.x = x;
+        s.y = y;
+        s.rotation = rotation*M_PI/180.0f;
+        s.depth = 0;
+        memcpy(s.rect, obj->Bounds, sizeof s.rect);
+        for (int c=0; c<3; c++)
+            s.color[c] = colorByte(obj->Color[c]);
+        s.color[3] = 255;
+        pushSprite(&sprites, &s, r->layer, obj->FillMode);
+        return;
+    }
+
+    // the shader places the object; view-projection is in the camera block
+    glUniform4f(Matrices.PlacementID, x, y, rotation*M_PI/180.0f, 1);
+    countStat(STAT_UNIFORMS);
+    draw3DObject(obj);
 }
 
 /**************************
@@ -214,112 +366,55 @@ float rectangle_rot_dir = 1;
 bool triangle_rot_status = true;
 bool rectangle_rot_status = true;
 VAO *triangle, *rectangle;
-int gameflag=0;
 VAO *redbox, *greenbox;
 VAO *brick1 ,*brick2 ,*brick3 , *brick4 ,*brick5, *brick6, *brick7, *brick8, *brick9, *brick10, *brick11, *brick12, *brick13, *brick14,*brick15;
+/* All bricks are drawn with one instanced draw of the brick1 quad; the
+ * instance buffer holds x, y and type of every live brick, placed between
+ * the last two ticks */
+struct BrickBatch {
+	GLuint VertexArrayID;
+	GLuint InstanceBuffer;
+	GLfloat instances[3*BRICK_POOL_CAPACITY];
+} brickbatch;
 VAO *rectlaser1 , *rectlaser2, *laser;//my change
-float collectingbox_xlength = 0.5; // length in x direction of collecting boxes
-float collectingbox_ylength = 0.75;//length in y direction of collecting boxes
-float redbox_x = -2.5 ;
-float greenbox_x = 2.5;
 /* Executed when a regular key is pressed/released/held-down */
 /* Prefered for Keyboard events */
-float laser1_xlength =0.5 ;
-float laser1_ylength= 0.6 ;
-float laser2_xlength= 1 ;
-float laser2_ylength= 0.2;
-float laser1_x= -7.4; //this is coordinate for both the laser and cannon2 i.e laser2 which
-float laser1_y=0 , brick_x[16];
-float brick_y[16] ;
-float h[6], g[6], speed[16];
-float laser2_rotation = 0;
-float laser_xlength =0.1;
-float laser_ylength = 0.05;
-float laserflag=0;
-int flag[16];
-float laserx=-7.4, lasery =0;
-float laserrotation ;
-long long int points=0;
-double last_update_time1 = glfwGetTime(), current_time1;
+GameState game; // everything the simulation touches, see game.h
+BrickScript levelscript; // loaded with --script
+LoadGovernor governor;
+double simtime; // time spent moving bricks this frame
+double ticklag; // real time not simulated yet; under one tick after update()
+#define MAX_CATCHUP_TICKS 8 // most ticks run for one frame
+#define IDLE_WAIT 0.5 // seconds between looks at the game while nothing moves
+bool redraw = false; // input came in: record a frame even though the game is over
 int mouseflag = 0;
-float speedupper , speedlower ;
-int f11=0, f12=0, f13=0, f14=0, f15=0,f16=0, f17=0;
-int f21=0, f22=0, f23=0, f24=0, f25=0, f26=0, f27=0;
-int f31=0, f32=0, f33 = 0, f34=0, f35=0, f36 =0 , f37=0;
-int negativeflag =0;
-float xpan = 0, ypan =0 ,zoom=1;
 	double xpos, ypos;
-void increasespeed()
+/* The load governor's steps: the first ones draw the world at a lower
+ * resolution, which any game can do without changing how it plays; the
+ * rest each halve the number of spawners refilling bricks, but never go
+ * below the nine of the normal game, so they only help with --spawners
+ * over 9. Bricks already falling are left alone. Headless runs keep full
+ * resolution, so a run with the same --seed draws the same frames. */
+const float renderscales[] = { 1, 0.75f, 0.5f };
+#define RENDER_SCALE_STEPS 2
+int scalesteps; // resolution steps the governor may take
+float renderscale = 1;
+void applyLoadLevel()
 {
-	int i;
-	for(i=1;i<10;i++)
-	{
-		if(speed[i] <3.5 )
-		{
-			speed[i]+=0.03;
-		}
-	}
-	if(speedupper < 3.5)
-	{
-		speedupper += 0.03;
-		speedlower += 0.03;
-	}
+	int level = governor.level;
+	int steps = level < scalesteps ? level : scalesteps;
+	renderscale = renderscales[steps];
+	level -= steps;
+	game.activespawners = game.nspawners >> level;
+	if(game.activespawners < 9)
+		game.activespawners = 9;
+	if(game.activespawners > game.nspawners)
+		game.activespawners = game.nspawners;
 }
-void decreasespeed()
+void governLoad(double rendertime)
 {
-	int i;
-	for(i=1;i<10;i++)
-	{
-		if(speed[i] > 0.001 )
-		{
-			speed[i]-=0.02;
-		}
-	}
-		if(speedlower > 0.02 )
-		{
-			speedlower-=0.02;
-			speedupper -= 0.02;
-		}
-}
-void moveRedBoxleft ()
-{
-	if(redbox_x > -7.2)
-		redbox_x -= 0.15;
-}
-void moveRedBoxright()
-{
-	if(redbox_x < 7.2)
-		redbox_x += 0.15;
-}
-void moveGreenBoxleft ()
-{
-	if(greenbox_x > -7.2)
-		greenbox_x -= 0.15;
-}
-void moveGreenBoxright()
-{
-	if(greenbox_x < 7.2)
-		greenbox_x += 0.15;
-}
-void movecannonup()
-{
-	if(laser1_y < 7.0)
-		laser1_y += 0.2;
-}
-void movecannondown()
-{
-	if(laser1_y > -5.3)
-		laser1_y -= 0.2;
-}
-void rotatecannonright()
-{
-	if(laser2_rotation > -70.0)
-		laser2_rotation -= 3;
-}
-void rotatecannonleft()
-{
-	if(laser2_rotation < 70.0)
-		laser2_rotation += 3;
+	if(updateGovernor(&governor, simtime, rendertime) != 0)
+		applyLoadLevel();
 }
 /*void incrementx()
 {
@@ -331,6 +426,8 @@ void rotatecannonleft()
 #define GLFW_KEY_RIGHT_ALT   346
 void keyboard (GLFWwindow* window, int key, int scancode, int action, int mods)
 {
+	TRACE_SCOPE("keyboard");
+	redraw = true;
      // Function is called first on GLFW_PRESS.
 		// printf("release %d\n", key);
     if (action == GLFW_RELEASE) {
@@ -339,15 +436,7 @@ void keyboard (GLFWwindow* window, int key, int scancode, int action, int mods)
 							case GLFW_KEY_RIGHT_ALT:
 								break;
 							case GLFW_KEY_SPACE:
-								current_time1 = glfwGetTime(); // Time in seconds
-								if ((current_time1 - last_update_time1) >= 0.7)  // atleast 0.5s elapsed since last frame
-								{	// do something every 0.5 seconds ..
-									last_update_time1 = current_time1;
-									laserflag=1;
-									laserrotation = laser2_rotation ;
-									lasery= laser1_y;
-									laserx= laser1_x;
-								}
+								fireLaser(&game);
 								break;
           /*  case GLFW_KEY_C:
                 rectangle_rot_status = !rectangle_rot_status;
@@ -374,31 +463,31 @@ void keyboard (GLFWwindow* window, int key, int scancode, int action, int mods)
 							if(glfwGetKey(window , GLFW_KEY_RIGHT_ALT)==GLFW_PRESS)
 							{
 								//printf("pressed %d\n", key);
-								moveRedBoxright();
+								moveRedBoxright(&game);
 							}
 							else if(glfwGetKey(window , GLFW_KEY_RIGHT_CONTROL)==GLFW_PRESS)
-									moveGreenBoxright();
+									moveGreenBoxright(&game);
 							else
 							{
-								xpan+=0.2;
+								panCamera(&view, 0.2, 0);
 							}
 							break;
 
 						case GLFW_KEY_LEFT:
 							if(glfwGetKey(window , GLFW_KEY_RIGHT_ALT)==GLFW_PRESS)
-									moveRedBoxleft();
+									moveRedBoxleft(&game);
 							else if(glfwGetKey(window , GLFW_KEY_RIGHT_CONTROL)==GLFW_PRESS)
-									moveGreenBoxleft();
+									moveGreenBoxleft(&game);
 							else{
-								xpan -= 0.2;
+								panCamera(&view, -0.2, 0);
 							}
 							break;
 						case GLFW_KEY_UP:
-							zoom +=0.1;
+							zoomCamera(&view, 0.1);
 							break;
 
 						case GLFW_KEY_DOWN:
-							zoom -= 0.1;
+							zoomCamera(&view, -0.1);
 							break;
             default:
                 break;
@@ -410,39 +499,57 @@ void keyboard (GLFWwindow* window, int key, int scancode, int action, int mods)
 /* Executed for character input (like in text boxes) */
 void keyboardChar (GLFWwindow* window, unsigned int key)
 {
+	TRACE_SCOPE("keyboardChar");
+	redraw = true;
 	switch (key) {
 		case 'Q':
 		case 'q':
             quit(window);
             break;
 		case 's':
-			movecannonup();
+			movecannonup(&game);
 			break;
 
 		case 'f':
-			movecannondown();
+			movecannondown(&game);
 			break;
 		case 'a':
-			rotatecannonleft();
+			rotatecannonleft(&game);
 			break;
 		case 'd':
-			rotatecannonright();
+			rotatecannonright(&game);
 			break;
 		case 'n':
-			increasespeed();
+			increasespeed(&game);
 			break;
 		case 'm':
-			decreasespeed();
+			decreasespeed(&game);
 			break;
 		case 'r':
-			gameflag=0;
-			points=0;
-			negativeflag=0;
+			restartGame(&game);
 			break;
 		case 'R':
-			gameflag=0;
-			points=0;
-			negativeflag=0;
+			restartGame(&game);
+			break;
+		case 'h':
+			debughud = !debughud;
+			break;
+		case 'b':
+			batching = !batching;
+			break;
+		case 'o':
+			profiling = !profiling;
+			break;
+		case 't':
+			writeTrace();
+			break;
+		case 'l':
+			reporttimes = true;
+			break;
+		case 'p':
+			game.stackmode = !game.stackmode;
+			if(!game.stackmode)
+				releaseBasketBricks(&game);
 			break;
 		default:
 			break;
@@ -452,6 +559,8 @@ void keyboardChar (GLFWwindow* window, unsigned int key)
 /* Executed when a mouse button is pressed/released */
 void mouseButton (GLFWwindow* window, int button, int action, int mods)
 {
+	TRACE_SCOPE("mouseButton");
+	redraw = true;
     switch (button) {
         case GLFW_MOUSE_BUTTON_LEFT:
 						if (action== GLFW_PRESS)
@@ -463,15 +572,7 @@ void mouseButton (GLFWwindow* window, int button, int action, int mods)
 							mouseflag=0;
 							if(xpos >50 && ypos <660)
 							{
-								current_time1 = glfwGetTime(); // Time in seconds
-								if ((current_time1 - last_update_time1) >= 0.7)  // atleast 0.5s elapsed since last frame
-								{	// do something every 0.5 seconds ..
-									last_update_time1 = current_time1;
-									laserflag=1;
-									laserrotation = laser2_rotation ;
-									lasery= laser1_y;
-									laserx= laser1_x;
-								}
+								fireLaser(&game);
 							}
 						}
             break;
@@ -490,10 +591,24 @@ void mouseButton (GLFWwindow* window, int button, int action, int mods)
 /* Modify the bounds of the screen here in glm::ortho or Field of View in glm::Perspective */
 void reshapeWindow (GLFWwindow* window, int width, int height)
 {
+	TRACE_SCOPE("reshapeWindow");
+	redraw = true;
     int fbwidth=width, fbheight=height;
     /* With Retina display on Mac OS X, GLFW's FramebufferSize
      is different from WindowSize */
-    glfwGetFramebufferSize(window, &fbwidth, &fbheight);
+    if (window)
+        glfwGetFramebufferSize(window, &fbwidth, &fbheight);
+    // GL belongs to the render thread, which picks the size up from the
+    // next frame recorded
+    framewidth = fbwidth;
+    frameheight = fbheight;
+}
+
+/* Fits the viewport and projections to a new framebuffer size */
+void resizeViewport (int fbwidth, int fbheight)
+{
+    hudwidth = fbwidth;
+    hudheight = fbheight;
 
 	GLfloat fov = 90.0f;
 
@@ -508,8 +623,9 @@ void reshapeWindow (GLFWwindow* window, int width, int height)
     // Perspective projection for 3D views
     // Matrices.projection = glm::perspective (fov, (GLfloat) fbwidth / (GLfloat) fbheight, 0.1f, 500.0f);
 
-    // Ortho projection for 2D views
-    Matrices.projection = glm::ortho(-(8.0f), (8.0f), (-8.0f), (8.0f), 0.1f, 500.0f);
+    // Ortho projection for 2D views, built by the camera
+    invalidateCamera(&camera);
+    hudprojection = glm::ortho(0.0f, (float)fbwidth, 0.0f, (float)fbheight, -1.0f, 1.0f);
 }
 
 
@@ -518,13 +634,13 @@ void createRedbox ()
 {
   // GL3 accepts only Triangles. Quads are not supported
   static const GLfloat vertex_buffer_data [] = {
-    -1*(collectingbox_xlength),-1*collectingbox_ylength,0, // vertex 1
-    collectingbox_xlength ,-1* collectingbox_ylength,0, // vertex 2
-    collectingbox_xlength, collectingbox_ylength,0, // vertex 3
+    -1*(game.collectingbox_xlength),-1*game.collectingbox_ylength,0, // vertex 1
+    game.collectingbox_xlength ,-1* game.collectingbox_ylength,0, // vertex 2
+    game.collectingbox_xlength, game.collectingbox_ylength,0, // vertex 3
 
-    collectingbox_xlength, collectingbox_ylength,0, // vertex 3
-    -1*collectingbox_xlength, collectingbox_ylength,0, // vertex 4
-    -1*collectingbox_xlength,-1* collectingbox_ylength,0  // vertex 1
+    game.collectingbox_xlength, game.collectingbox_ylength,0, // vertex 3
+    -1*game.collectingbox_xlength, game.collectingbox_ylength,0, // vertex 4
+    -1*game.collectingbox_xlength,-1* game.collectingbox_ylength,0  // vertex 1
   };
 
   static const GLfloat color_buffer_data [] = {
@@ -545,13 +661,13 @@ void createGreenbox ()
 {
   // GL3 accepts only Triangles. Quads are not supported
 	static const GLfloat vertex_buffer_data [] = {
-		-1*(collectingbox_xlength),-1*collectingbox_ylength,0, // vertex 1
-		collectingbox_xlength ,-1* collectingbox_ylength,0, // vertex 2
-		collectingbox_xlength, collectingbox_ylength,0, // vertex 3
+		-1*(game.collectingbox_xlength),-1*game.collectingbox_ylength,0, // vertex 1
+		game.collectingbox_xlength ,-1* game.collectingbox_ylength,0, // vertex 2
+		game.collectingbox_xlength, game.collectingbox_ylength,0, // vertex 3
 
-		collectingbox_xlength, collectingbox_ylength,0, // vertex 3
-		-1*collectingbox_xlength, collectingbox_ylength,0, // vertex 4
-		-1*collectingbox_xlength,-1* collectingbox_ylength,0  // vertex 1
+		game.collectingbox_xlength, game.collectingbox_ylength,0, // vertex 3
+		-1*game.collectingbox_xlength, game.collectingbox_ylength,0, // vertex 4
+		-1*game.collectingbox_xlength,-1* game.collectingbox_ylength,0  // vertex 1
 	};
 
   static const GLfloat color_buffer_data [] = {
@@ -679,8 +795,6 @@ void createlaser()
   // create3DObject creates and returns a handle to a VAO that can be used later
   laser = create3DObject(GL_TRIANGLES, 6, vertex_buffer_data, color_buffer_data, GL_FILL);
 }
-float brick_xlength = 0.2;
-float brick_ylength = 0.3;
 void createBrick1 ()
 {
   // GL3 accepts only Triangles. Quads are not supported
@@ -707,57 +821,108 @@ void createBrick1 ()
   // create3DObject creates and returns a handle to a VAO that can be used later
   brick1 = create3DObject(GL_TRIANGLES, 6, vertex_buffer_data, color_buffer_data, GL_FILL);
 }
-void createBrick2 ()
-{
-  // GL3 accepts only Triangles. Quads are not supported
-  static const GLfloat vertex_buffer_data [] = {
-    -1*brick_xlength,-1* brick_ylength,0, // vertex 1
-    brick_xlength,-1*brick_ylength,0, // vertex 2
-    brick_xlength,brick_ylength,0, // vertex 3
-
-    brick_xlength, brick_ylength,0, // vertex 3
-    -1*brick_xlength, brick_ylength,0, // vertex 4
-    -1*brick_xlength,-1*brick_ylength,0  // vertex 1
-  };
-
-  static const GLfloat color_buffer_data [] = {
-    1,0,0, // color 1
-    1,0,0, // color 2
-    1,0,0, // color 3
-
-    1,0,0, // color 3
-    1,0,0, // color 4
-    1,0,0  // color 1
-  };
+/* colours of the bricks, indexed by BrickType */
+const GLfloat brickpalette[3*3] = {
+	0,0,0,
+	1,0,0,
+	0,1,0
+};
 
-  // create3DObject creates and returns a handle to a VAO that can be used later
-  brick2 = create3DObject(GL_TRIANGLES, 6, vertex_buffer_data, color_buffer_data, GL_FILL);
-}
-void createBrick3 ()
+void createBrickBatch ()
 {
-  // GL3 accepts only Triangles. Quads are not supported
-  static const GLfloat vertex_buffer_data [] = {
-    -1*brick_xlength,-1* brick_ylength,0, // vertex 1
-    brick_xlength,-1*brick_ylength,0, // vertex 2
-    brick_xlength,brick_ylength,0, // vertex 3
-
-    brick_xlength, brick_ylength,0, // vertex 3
-    -1*brick_xlength, brick_ylength,0, // vertex 4
-    -1*brick_xlength,-1*brick_ylength,0  // vertex 1
-  };
-
-  static const GLfloat color_buffer_data [] = {
-		0,1,0, // color 1
-    0,1,0, // color 2
-    0,1,0, // color 3
+	glGenVertexArrays(1, &brickbatch.VertexArrayID);
+	glGenBuffers(1, &brickbatch.InstanceBuffer);
+	bindVertexArray(brickbatch.VertexArrayID);
+
+	// the quad, shared with brick1
+	bindArrayBuffer(brick1->VertexBuffer);
+	glVertexAttribPointer(0, 2, brick1->PositionType, GL_FALSE, brick1->Stride, (void*)0);
+	enableVertexAttrib(0);
+
+	// attribute 2: x, y, type, advancing once per brick instead of per vertex
+	bindArrayBuffer(brickbatch.InstanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(brickbatch.instances), NULL, GL_STREAM_DRAW);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+	glVertexAttribDivisor(2, 1);
+	enableVertexAttrib(2);
+	bindVertexArray(0);
+}
 
-    0,1,0, // color 3
-    0,1,0, // color 4
-    0,1,0  // color 1
-  };
+/* Writes x, y and type of every live brick into the frame */
+void recordBricks (RenderFrame* frame)
+{
+	const BrickPool* bricks = &game.bricks;
+	for(int i=0;i<bricks->count;i++)
+	{
+		frame->bricks[3*i] = bricks->x[i];
+		frame->bricks[3*i+1] = bricks->y[i];
+		frame->bricks[3*i+2] = bricks->type[i];
+		frame->prevbricks[2*i] = bricks->prevx[i];
+		frame->prevbricks[2*i+1] = bricks->prevy[i];
+	}
+	frame->nbricks = bricks->count;
+	frame->brickorder = frame->nobjects;
+}
 
-  // create3DObject creates and returns a handle to a VAO that can be used later
-  brick3 = create3DObject(GL_TRIANGLES, 6, vertex_buffer_data, color_buffer_data, GL_FILL);
+/* One upload and one draw call however many bricks there are; with
+ * batching on the bricks join the other sprites instead. Bricks out of
+ * view are left out either way. */
+void drawBricks (const RenderFrame* frame)
+{
+	int count = frame->nbricks;
+	if(count == 0)
+		return;
+	if(frame->batching)
+	{
+		SpriteInstance s;
+		s.rotation = 0;
+		s.depth = 0;
+		memcpy(s.rect, brick1->Bounds, sizeof s.rect);
+		s.color[3] = 255;
+		for(int i=0;i<count;i++)
+		{
+			const GLfloat* b = &frame->bricks[3*i];
+			s.x = tween(frame->prevbricks[2*i], b[0], frame->alpha);
+			s.y = tween(frame->prevbricks[2*i+1], b[1], frame->alpha);
+			if(!inView(brick1, s.x, s.y, false))
+			{
+				countStat(STAT_CULLED);
+				continue;
+			}
+			for(int c=0;c<3;c++)
+				s.color[c] = colorByte(brickpalette[3*(int)b[2] + c]);
+			pushSprite(&sprites, &s, 0, brick1->FillMode);
+		}
+		return;
+	}
+	int n = 0;
+	for(int i=0;i<count;i++)
+	{
+		GLfloat* instance = &brickbatch.instances[3*n];
+		instance[0] = tween(frame->prevbricks[2*i], frame->bricks[3*i], frame->alpha);
+		instance[1] = tween(frame->prevbricks[2*i+1], frame->bricks[3*i+1], frame->alpha);
+		instance[2] = frame->bricks[3*i+2];
+		if(inView(brick1, instance[0], instance[1], false))
+			n++;
+	}
+	countStat(STAT_CULLED, count - n);
+	count = n;
+	if(count == 0)
+		return;
+	bindArrayBuffer(brickbatch.InstanceBuffer);
+	// orphan last frame's data so the driver need not wait for it
+	glBufferData(GL_ARRAY_BUFFER, sizeof(brickbatch.instances), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, 3*count*sizeof(GLfloat), brickbatch.instances);
+	countUpload(3*count*sizeof(GLfloat));
+
+	polygonMode(brick1->FillMode);
+	glUniform4f(Matrices.PlacementID, 0, 0, 0, 1);
+	glUniform1i(Matrices.InstancedID, 1);
+	bindVertexArray(brickbatch.VertexArrayID);
+	glDrawArraysInstanced(brick1->PrimitiveMode, 0, brick1->NumVertices, count);
+	glUniform1i(Matrices.InstancedID, 0);
+	countDraw(brick1->NumVertices, count);
+	countStat(STAT_UNIFORMS, 3);
 }
 
 VAO *mirror1 , *mirror2;
@@ -815,62 +980,6 @@ void createmirror2 ()
 	// create3DObject creates and returns a handle to a VAO that can be used later
 	mirror2 = create3DObject(GL_TRIANGLES, 6, vertex_buffer_data, color_buffer_data, GL_FILL);
 }
-struct VAO* scorehorizontal;
-void createscorehorizontal()
-{
-// GL3 accepts only Triangles. Quads are not supported static
-  const GLfloat vertex_buffer_data [] = {
-    0,0,0, // vertex 1
-    0.4,0,0, // vertex 2
-    0.4, 0.10,0, // vertex 3
-
-   0.4, 0.10,0, // vertex 3
-    0, 0.10,0, // vertex 4
-    0,0,0//i,0  // vertex 1
-  };
-
-  static const GLfloat color_buffer_data [] = {
-    0,0,0, // color 1
-    0,0,0, // color 2
-    0,0,0, // color 3
-
-    0,0,0, // color 3
-    0,0,0, // color 4
-    0,0,0  // color 1
-  };
-
-  // create3DObject creates and returns a handle to a VAO that can be used later
-  scorehorizontal = create3DObject(GL_TRIANGLES, 6, vertex_buffer_data, color_buffer_data, GL_FILL);
-
-}
-struct VAO* scorevertical;
-void createscorevertical()
-{
-// GL3 accepts only Triangles. Quads are not supported static
-  const GLfloat vertex_buffer_data [] = {
-    0,0,0, // vertex 1
-    0.07,0,0, // vertex 2
-    0.07, 0.4,0, // vertex 3
-
-   0.07, 0.4,0, // vertex 3
-    0, 0.4,0, // vertex 4
-    0,0,0//i,0  // vertex 1
-  };
-
-  static const GLfloat color_buffer_data [] = {
-    0,0,0, // color 1
-    0,0,0, // color 2
-    0,0,0, // color 3
-
-    0,0,0, // color 3
-    0,0,0, // color 4
-    0,0,0  // color 1
-  };
-
-  // create3DObject creates and returns a handle to a VAO that can be used later
-  scorevertical = create3DObject(GL_TRIANGLES, 6, vertex_buffer_data, color_buffer_data, GL_FILL);
-
-}
 float camera_rotation_angle = 90;
 float rectangle_rotation = 0;
 float triangle_rotation = 0;
@@ -878,770 +987,267 @@ float redbox_rotation =0 ;
 float greenbox_rotation= 0;
 float laser1_rotation=0;
 
-/* Render the scene with openGL */
-/* Edit this function according to your assignment */
-void draw (GLFWwindow* window)
+/* The simulation's lines of the debug HUD, written into the frame */
+void recordStatus (RenderFrame* frame)
 {
-  // clear the color and depth in the frame buffer
-	if(gameflag==0)
-	{
-  glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	Matrices.projection = glm::ortho(-(8.0f)/zoom+xpan, (8.0f)/zoom+xpan, (-8.0f)/zoom+ypan, (8.0f)/zoom+ypan, 0.1f, 500.0f);
-int i ;
-	double angle ;
-	for(i=1;i<10;i++)
+	snprintf(frame->status, sizeof frame->status,
+			"BRICKS %d  SPAWNERS %d/%d  LANES %d\n"
+			"SIM %.3f MS  COST %.3f MS  LOAD LEVEL %d  SCALE %.2f\n"
+			"SPEED %.3f-%.3f  STACKING %s  SCRIPT %s",
+			game.bricks.count, game.activespawners, game.nspawners, game.nlanes,
+			simtime*1000, governor.cost*1000, governor.level, renderscale,
+			game.speedlower, game.speedupper, game.stackmode ? "ON" : "OFF", game.vm.script ? "ON" : "OFF");
+}
+
+/* Rolling CPU and GPU time of every part of the frame, under the score */
+void drawProfile ()
+{
+	static const GLubyte black[4] = {0, 0, 0, 255};
+	char line[64];
+	float size = 12, x = hudwidth - 26*size, y = hudheight - 110;
+
+	pushText(&hudtext, x, y, size, "PROFILE", black);
+	pushText(&hudtext, x + 10*size, y, size, "CPU MS", black);
+	pushText(&hudtext, x + 18*size, y, size, "GPU MS", black);
+	for(int i=0;i<profiler.nscopes;i++)
 	{
-if(brick_y[i] >=10)
+		const ProfileScope* scope = &profiler.scopes[i];
+		y -= 1.5f*size;
+		pushText(&hudtext, x, y, size, scope->name, black);
+		snprintf(line, sizeof line, "%.3f", scope->cpu);
+		pushText(&hudtext, x + 10*size, y, size, line, black);
+		snprintf(line, sizeof line, "%.3f", scope->gpu);
+		pushText(&hudtext, x + 18*size, y, size, line, black);
+	}
+}
+
+/* Score, frame rate and, with 'h', the debug counters, in the top left corner */
+void drawHud (const RenderFrame* frame)
 {
-	//cout << "Hello\n";
-	flag[i]=0;
+	static const GLubyte black[4] = {0, 0, 0, 255};
+	static const GLubyte blue[4] = {0, 0, 160, 255};
+	char line[RENDER_STATUS + 256];
+	float size = 14, x = 10, y = hudheight - 10 - size;
+
+	snprintf(line, sizeof line, "SCORE %lld", frame->points);
+	pushText(&hudtext, x, y, size, line, blue);
+	y -= 1.75f*size;
+	snprintf(line, sizeof line, "FPS %.0f  FRAME %.2f MS", frametime > 0 ? 1/frametime : 0, frametime*1000);
+	pushText(&hudtext, x, y, size, line, black);
+	if(frame->debughud)
+	{
+		snprintf(line, sizeof line,
+				"%s\n"
+				"SPRITE DRAWS %d  TEXT DRAWS %d  BATCHING %s\n"
+				"GL STATE CALLS %lld  SKIPPED %lld  CAMERA UPLOADS %d  GPU FRAME %.2f MS\n"
+				"DRAWS %lld  VERTICES %lld  UNIFORMS %lld  UPLOADS %lld (%lld BYTES)  VAO BINDS %lld  CULLED %lld",
+				frame->status, sprites.draws, hudtext.draws, frame->batching ? "ON" : "OFF",
+				glstate.framecalls, glstate.frameskipped, camera.uploads, frametimer.gpu*1000,
+				renderStat(STAT_DRAWS), renderStat(STAT_VERTICES), renderStat(STAT_UNIFORMS),
+				renderStat(STAT_UPLOADS), renderStat(STAT_UPLOAD_BYTES), renderStat(STAT_VAO_BINDS),
+				renderStat(STAT_CULLED));
+		pushText(&hudtext, x, y - 1.75f*size, size, line, black);
+	}
+
+	if(frame->profiling)
+		drawProfile();
+
+	flushText(&hudtext, &hudprojection[0][0]);
 }
+
+/* First use of programID: wait for the link and set the uniforms that never change */
+void linkProgram ()
+{
+	TRACE_SCOPE("linkProgram");
+	finishProgram(programID);
+	// Get a handle for our "Placement" uniform; the matrices come from the camera block
+	useCameraBlock(programID);
+	Matrices.PlacementID = glGetUniformLocation(programID, "Placement");
+	Matrices.InstancedID = glGetUniformLocation(programID, "Instanced");
+	Matrices.PaletteID = glGetUniformLocation(programID, "Palette");
+	useProgram(programID);
+	glUniform1i(Matrices.InstancedID, 0);
+	glUniform3fv(Matrices.PaletteID, 3, brickpalette);
+	countStat(STAT_UNIFORMS, 2);
+	linked = true;
 }
-if(mouseflag==1)
+
+/* Edit this function according to your assignment */
+/* Moves the game one frame on and records what it looks like; runs on the
+ * simulation thread, so nothing here may touch GL */
+void update (GLFWwindow* window, RenderFrame* frame)
+{
+	TRACE_SCOPE("update");
+	frame->running = game.gameflag==0 || redraw;
+	frame->width = framewidth;
+	frame->height = frameheight;
+	frame->view = view;
+	frame->batching = batching;
+	frame->debughud = debughud;
+	frame->profiling = profiling;
+	frame->renderscale = renderscale;
+	frame->reporttimes = reporttimes;
+	reporttimes = false;
+	frame->nobjects = 0;
+	frame->nbricks = 0;
+	frame->simtime = 0;
+	frame->brickorder = 0;
+	if(frame->running)
+	{
+	double angle = game.laser2_rotation;
+if(mouseflag==1 && game.gameflag==0)
 {
 
 glfwGetCursorPos(window, &xpos, &ypos);
 //cout << xpos << "\t" << ypos << "\n";
 if(ypos > 660 )
 {
-	if((redbox_x - collectingbox_xlength)*50 <= (xpos -400) && (redbox_x + collectingbox_xlength)* 50 >= (xpos-400))
+	if((game.redbox_x - game.collectingbox_xlength)*50 <= (xpos -400) && (game.redbox_x + game.collectingbox_xlength)* 50 >= (xpos-400))
 	{
 		if( (xpos/50) <15 && (xpos/50)>1 )
 		{
-		redbox_x= (xpos -400)/50;
+		game.redbox_x= (xpos -400)/50;
 	}
 	}
-	else if( (greenbox_x- collectingbox_xlength)*50 <= (xpos-400) && (greenbox_x +collectingbox_xlength)*50 >= (xpos-400))
+	else if( (game.greenbox_x- game.collectingbox_xlength)*50 <= (xpos-400) && (game.greenbox_x +game.collectingbox_xlength)*50 >= (xpos-400))
 	{
 		if( (xpos/50) <15 && (xpos/50)>1 )
 		{
-			greenbox_x= (xpos -400)/50;
+			game.greenbox_x= (xpos -400)/50;
 		}
 	}
 }
-else if(xpos <=50 && (400 - ypos) >= (laser1_y- laser1_ylength)*50 && (400 - ypos) <= (laser1_y + laser1_ylength)*50)
+else if(xpos <=50 && (400 - ypos) >= (game.laser1_y- laser1_ylength)*50 && (400 - ypos) <= (game.laser1_y + laser1_ylength)*50)
 {
 	if( (ypos)< 660 && ypos >25)
-	laser1_y = (400 - ypos)/50 ;
+	game.laser1_y = (400 - ypos)/50 ;
 }
 else{
-	angle = atan ((400 - ypos - (laser1_y*50))/xpos);
+	angle = atan ((400 - ypos - (game.laser1_y*50))/xpos);
 	angle *= 180/M_PI;
 }
-laser2_rotation = angle ;
+game.laser2_rotation = angle ;
 }
-  // use the loaded shader program
-  // Don't change unless you know what you are doing
-  glUseProgram (programID);
-/*	if (laser_xlength < 6.4)
-		cout << laser_xlength++;*/
-  // Eye - Location of camera. Don't change unless you are sure!!
-  glm::vec3 eye ( 5*cos(camera_rotation_angle*M_PI/180.0f), 0, 5*sin(camera_rotation_angle*M_PI/180.0f) );
-  // Target - Where is the camera looking at.  Don't change unless you are sure!!
-  glm::vec3 target (0, 0, 0);
-  // Up - Up vector defines tilt of camera.  Don't change unless you are sure!!
-  glm::vec3 up (0, 1, 0);
-
-  // Compute Camera matrix (view)
-  // Matrices.view = glm::lookAt( eye, target, up ); // Rotating Camera for 3D
-  //  Don't change unless you are sure!!
-  Matrices.view = glm::lookAt(glm::vec3(0,0,3), glm::vec3(0,0,0), glm::vec3(0,1,0)); // Fixed camera for 2D (ortho) in XY plane
-
-  // Compute ViewProject matrix as view/camera might not be changed for this frame (basic scenario)
-  //  Don't change unless you are sure!!
-  glm::mat4 VP = Matrices.projection * Matrices.view;
-
-  // Send our transformation to the currently bound shader, in the "MVP" uniform
-  // For each model you render, since the MVP will be different (at least the M part)
-  //  Don't change unless you are sure!!
-  glm::mat4 MVP;	// MVP = Projection * View * Model
+	double simstart = clockTime();
+	// the game moves in ticks of GAME_TICK however often frames come;
+	// what is left over is drawn as the way between the last two ticks
+	while (ticklag >= GAME_TICK) {
+		TRACE_SCOPE("stepGame");
+		stepGame(&game);
+		ticklag -= GAME_TICK;
+	}
+	frame->alpha = ticklag/GAME_TICK;
+	simtime = clockTime() - simstart;
+	frame->simtime = simtime;
 
 	//mirror1
-	float mirror1x =6.0 , mirror1y= 0.0;
-	float mirror2x = -4.0 , mirror2y = -4.5;
-	float mirror1rotation = 90;
-	float mirror2rotation = 120;
-		Matrices.model = glm::mat4(1.0f);
-		glm::mat4 translatemirror1 = glm::translate (glm::vec3(mirror1x, mirror1y, 0.0f)); // glTranslatef
-		glm::mat4 rotatemirror1 = glm::rotate((float)(mirror1rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-		Matrices.model *= translatemirror1*rotatemirror1;
-		MVP = VP * Matrices.model; // MVP = p * V * M
-		glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-		srand(time(NULL));
-		draw3DObject(mirror1);
-
-		Matrices.model = glm::mat4(1.0f);
-		glm::mat4 translatemirror2 = glm::translate (glm::vec3(mirror2x, mirror2y, 0.0f)); // glTranslatef
-		glm::mat4 rotatemirror2 = glm::rotate((float)(mirror2rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-		Matrices.model *= translatemirror2*rotatemirror2;
-		MVP = VP * Matrices.model; // MVP = p * V * M
-		glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-		srand(time(NULL));
-		draw3DObject(mirror2);
-	//	cout << laserrotation << endl;
-//cout << lasery << "\t" << mirror1y+ sin(mirror1rotation) << endl;
-		if(lasery+abs(sin(laserrotation*M_PI/180)) <( mirror1y + 1* sin(mirror1rotation*M_PI/180.0f)) && ( lasery+abs(sin(laserrotation*M_PI/180)) > mirror1y -1*sin(mirror1rotation*M_PI/180.0f)))
-		{
-		//	cout << "insidey\n";
-			if(abs(mirror1x - laserx)<= laser_xlength + ( 0.5*cos(laserrotation*M_PI/180)))
-			{
-		//		cout << "insidex\n";
-				laserrotation = 2*mirror1rotation -laserrotation;
-			}
-		}
-		if((abs(mirror2x - laserx)<= laser_xlength +0.05) && (abs(mirror2y - lasery)<= laser_xlength+ 1 ))
-		{
-				laserrotation = 2*120 -laserrotation;
-		}
+		drawObject(frame, SCOPE_MIRRORS, mirror1, mirror1x, mirror1y, mirror1rotation);
+
+		drawObject(frame, SCOPE_MIRRORS, mirror2, mirror2x, mirror2y, mirror2rotation);
 ///////// creating the red box
-  Matrices.model = glm::mat4(1.0f);
-  glm::mat4 translateRedbox = glm::translate (glm::vec3(redbox_x, -7, 0));        // glTranslatef
-  glm::mat4 rotateRedbox = glm::rotate((float)(redbox_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translateRedbox * rotateRedbox);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-  draw3DObject(redbox);
+  drawObject(frame, SCOPE_BASKETS, redbox, game.redbox_x, -7, redbox_rotation);
 
 
 ///////// creating the green box
-  Matrices.model = glm::mat4(1.0f);
-  glm::mat4 translateGreenbox = glm::translate (glm::vec3(greenbox_x, -7, 0));        // glTranslatef
-  glm::mat4 rotateGreenbox = glm::rotate((float)(redbox_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translateGreenbox * rotateGreenbox);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-  draw3DObject(greenbox);
+  drawObject(frame, SCOPE_BASKETS, greenbox, game.greenbox_x, -7, redbox_rotation);
 
 	///////// creating the laser1
-	  Matrices.model = glm::mat4(1.0f);
-	  glm::mat4 translaterectlaser1 = glm::translate (glm::vec3(laser1_x, laser1_y, 0));        // glTranslatef
-	  glm::mat4 rotaterectlaser1 = glm::rotate((float)(laser1_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-	  Matrices.model *= (translaterectlaser1 * rotaterectlaser1);
-	  MVP = VP * Matrices.model;
-	  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-	  draw3DObject(rectlaser1);
+	  drawMovingObject(frame, SCOPE_CANNON, rectlaser1, game.laser1_x, game.prevlaser1_y, laser1_rotation,
+			  game.laser1_x, game.laser1_y, laser1_rotation);
 
 		///////// creating the laser2
-		  Matrices.model = glm::mat4(1.0f);
-		  glm::mat4 translaterectlaser2 = glm::translate (glm::vec3(laser1_x, laser1_y, 0));        // glTranslatef
-		  glm::mat4 rotaterectlaser2 = glm::rotate((float)(laser2_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-		  Matrices.model *= (translaterectlaser2 * rotaterectlaser2);
-		  MVP = VP * Matrices.model;
-		  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-		  draw3DObject(rectlaser2);
-//laser_xlength +=1.5;
+		  drawMovingObject(frame, SCOPE_CANNON, rectlaser2, game.laser1_x, game.prevlaser1_y, game.prevlaser2_rotation,
+			  game.laser1_x, game.laser1_y, game.laser2_rotation);
 			///////// creating the laser
-			if(laserflag==1 )
+			if(game.laserflag==1 )
 			{
-				if(laserx>=8 || laserx<=-8 || lasery >=8 || lasery<= -6)
-				{
-					//cout << "hello world\n";
-					laserflag=0;
-					laserx = -7;
-				}
-
-				Matrices.model = glm::mat4(1.0f);
-glm::mat4 translatelaser = glm::translate (glm::vec3(laserx, lasery, 0));  // glTranslatef
-		//		glm::mat4 translatelaser = glm::translate (glm::vec3(-7.4, lasery, 0));        // glTranslatef
-				glm::mat4 rotatelaser = glm::rotate((float)(laserrotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-				Matrices.model *= ( translatelaser *rotatelaser );
-				MVP = VP * Matrices.model;
-				glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-				draw3DObject(laser);
-
-				for(i=1;i<10; i++)
-				{
-					if(lasery <= brick_y[i]+brick_ylength && lasery >= brick_y[i] - brick_ylength)
-					{
-						if(abs(brick_x[i]-laserx) <=( laser_xlength*cos(laserrotation*M_PI/180)+ brick_xlength) || abs(laserx - brick_x[i]) <=( abs(laser_xlength*cos(laserrotation*M_PI/180))+ brick_xlength))
-						{
-							brick_y[i] =10;
-							flag[i]=0;
-							laserflag=0;
-							laserx = -7;
-								if((i%3)==2 || (i%3)==0)
-								{
-									//if(points>=2)
-										points -= 2; //decreasing points on hitting green or red brick
-								}
-								else
-								{
-									points += 3;  //increasing points on hitting black brick
-								}
-						//	cout << "hit\n";
-							break;
-						}
-					}
-				}
-
-				laserx+= 0.5 *cos(laserrotation*M_PI/180); //speed * cos to get distance in x direction
-				lasery+= 0.5 *sin(laserrotation*M_PI/180);
-				if(laserx>=8 || laserx<=-8 || lasery >=8 || lasery<= -6)
-				{
-					//cout << "hello world\n";
-					laserflag=0;
-					laserx = -7;
-				}
-
+				drawMovingObject(frame, SCOPE_LASER, laser, game.prevlaserx, game.prevlasery, game.prevlaserrotation,
+					game.laserx, game.lasery, game.laserrotation);
 			}
-//creating brick1
-		//		laserx+= 0.001;
-h[1] =-5.0,h[2]=-0.99 , h[3]=3.01 ;
-g[1]=-1 ,g[2] = 3.00 ,g[3]=7.00 ;
+				recordBricks(frame);
 
-for(i=1;i<10;i++)
-{
-				if(flag[i]==0)
-				{
-					flag[i]=1;
-					int j = ((i-1)/3) +1;
-					/*srand (time(NULL));
-				brick_x[i] = rand() %12 -6;*/
-				speed[i]= 0.01 +static_cast <float> (rand()) /( static_cast <float> (RAND_MAX/speedupper - speedlower));
-				brick_x[i]= h[j]+ static_cast <float> (rand()) /( static_cast <float> (RAND_MAX/(g[j]-h[j])));
-				//cout << speed[i] << endl;
-		//		cout << "hello again\n" << brick_x[1];
-			}
-		}
-				Matrices.model = glm::mat4(1.0f);
-				glm::mat4 translatebrick1 = glm::translate (glm::vec3(brick_x[1], brick_y[1], 0));        // glTranslatef
-				glm::mat4 rotatebrick1 = glm::rotate((float)(0*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-				Matrices.model *= (translatebrick1 * rotatebrick1);
-				MVP = VP * Matrices.model;
-				glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-				draw3DObject(brick1);
-
-				Matrices.model = glm::mat4(1.0f);
-				glm::mat4 translatebrick2 = glm::translate (glm::vec3(brick_x[2], brick_y[2], 0));        // glTranslatef
-				glm::mat4 rotatebrick2 = glm::rotate((float)(0*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-				Matrices.model *= (translatebrick2 * rotatebrick2);
-				MVP = VP * Matrices.model;
-				glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-				draw3DObject(brick2);
-
-				Matrices.model = glm::mat4(1.0f);
-				glm::mat4 translatebrick3 = glm::translate (glm::vec3(brick_x[3], brick_y[3], 0));        // glTranslatef
-				glm::mat4 rotatebrick3 = glm::rotate((float)(0*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-				Matrices.model *= (translatebrick3 * rotatebrick3);
-				MVP = VP * Matrices.model;
-				glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-				draw3DObject(brick3);
-
-				Matrices.model = glm::mat4(1.0f);
-				glm::mat4 translatebrick4 = glm::translate (glm::vec3(brick_x[4], brick_y[4], 0));        // glTranslatef
-				glm::mat4 rotatebrick4 = glm::rotate((float)(0*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-				Matrices.model *= (translatebrick4 * rotatebrick4);
-				MVP = VP * Matrices.model;
-				glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-				draw3DObject(brick1);
-
-				Matrices.model = glm::mat4(1.0f);
-				glm::mat4 translatebrick5 = glm::translate (glm::vec3(brick_x[5], brick_y[5], 0));        // glTranslatef
-				glm::mat4 rotatebrick5 = glm::rotate((float)(0*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-				Matrices.model *= (translatebrick5 * rotatebrick5);
-				MVP = VP * Matrices.model;
-				glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-				draw3DObject(brick2);
-
-				Matrices.model = glm::mat4(1.0f);
-				glm::mat4 translatebrick6 = glm::translate (glm::vec3(brick_x[6], brick_y[6], 0));        // glTranslatef
-				glm::mat4 rotatebrick6 = glm::rotate((float)(0*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-				Matrices.model *= (translatebrick6 * rotatebrick6);
-				MVP = VP * Matrices.model;
-				glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-				draw3DObject(brick3);
-
-				Matrices.model = glm::mat4(1.0f);
-				glm::mat4 translatebrick7 = glm::translate (glm::vec3(brick_x[7], brick_y[7], 0));        // glTranslatef
-				glm::mat4 rotatebrick7 = glm::rotate((float)(0*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-				Matrices.model *= (translatebrick7 * rotatebrick7);
-				MVP = VP * Matrices.model;
-				glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-				draw3DObject(brick1);
-
-				Matrices.model = glm::mat4(1.0f);
-				glm::mat4 translatebrick8 = glm::translate (glm::vec3(brick_x[8], brick_y[8], 0));        // glTranslatef
-				glm::mat4 rotatebrick8 = glm::rotate((float)(0*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-				Matrices.model *= (translatebrick8 * rotatebrick8);
-				MVP = VP * Matrices.model;
-				glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-				draw3DObject(brick2);
-
-				Matrices.model = glm::mat4(1.0f);
-				glm::mat4 translatebrick9 = glm::translate (glm::vec3(brick_x[9], brick_y[9], 0));        // glTranslatef
-				glm::mat4 rotatebrick9 = glm::rotate((float)(0*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-				Matrices.model *= (translatebrick9 * rotatebrick9);
-				MVP = VP * Matrices.model;
-				glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-				draw3DObject(brick3);
-
-
-				for(i=1;i<10 ;i++)
-				{
-					if(brick_x[i] > (redbox_x- collectingbox_xlength)  && brick_x[i] < (redbox_x + collectingbox_xlength) )
-					{
-						if(abs(-7 - brick_y[i] ) < (collectingbox_ylength + brick_ylength))
-						{
-							if((i%3)==2)
-							{
-								points += 2;
-				//				cout << points << "red" << endl;
-							}
-							brick_y[i] =10;
-							flag[i]=0;
-							if(i%3==1)
-							{
-							//	exit(EXIT_SUCCESS);
-									gameflag=1;
-								//terminate the game i.e gameover
-							}
-						}
-					}
-					else if(brick_x[i] > (greenbox_x- collectingbox_xlength)  && brick_x[i] < (greenbox_x + collectingbox_xlength) )
-					{
-						if(abs(-7 - brick_y[i]) < (collectingbox_ylength + brick_ylength))
-						{
-							if(i%3==0)
-							{
-								points += 2;
-			//					cout << points << "green" << endl;
-							}
-							brick_y[i] =10;
-							flag[i]=0;
-							if(i%3==1)
-							{
-								gameflag=1;
-								//terminate the game i.e gameover
-							}
-						}
-					}
-				if(brick_y[i] > -7 )
-					brick_y[i] -=speed[i];
-				else{
-					brick_y[i] =10;
-					flag[i]=0;
-				}
-			}
-int a ,b;
-int temppoints;
-temppoints =points;
-if(temppoints<0)
-{
-	temppoints = abs(temppoints);
-	negativeflag=1;
+	drawObject(frame, SCOPE_LINE, line, 0, -6.0, 0);
+	frame->points = game.points;
+	if(frame->debughud)
+		recordStatus(frame);
+
+  float increments = 1;
+
+  //camera_rotation_angle++; // Simulating camera rotation
+  triangle_rotation = triangle_rotation + increments*triangle_rot_dir*triangle_rot_status;
+  rectangle_rotation = rectangle_rotation + increments*rectangle_rot_dir*rectangle_rot_status;
 }
-else
-	negativeflag=0;
-b=temppoints%10;
-a=temppoints/10;
-switch(a)
-{
-case 0:
-	f21=1;
-	f22=1;
-	f23=1;
-	f24=1;
-	f25=1;
-	f26=1;
-	f27=0;
-	break;
-case 1:
-	f21=0;
-	f22=1;
-	f23=1;
-	f24=0;
-	f25=0;
-	f26=0;
-	f27=0;
-	break;
-case 2:
-	f21=1;
-	f22=1;
-	f23=0;
-	f24=1;
-	f25=1;
-	f26=0;
-	f27=1;
-	break;
-case 3:
-	f21=1;
-	f22=1;
-	f23=1;
-	f24=1;
-	f25=0;
-	f26=0;
-	f27=1;
-	break;
-case 4:
-	f21=0;
-	f22=1;
-	f23=1;
-	f24=0;
-	f25=0;
-	f26=1;
-	f27=1;
-	break;
-case 5:
-	f21=1;
-	f22=0;
-	f23=1;
-	f24=1;
-	f25=0;
-	f26=1;
-	f27=1;
-	break;
-case 6:
-	f21=1;
-	f22=0;
-	f23=1;
-	f24=1;
-	f25=1;
-	f26=1;
-	f27=1;
-	break;
-case 7:
-	f21=1;
-	f22=1;
-	f23=1;
-	f24=0;
-	f25=0;
-	f26=0;
-	f27=0;
-	break;
-case 8:
-	f21=1;
-	f22=1;
-	f23=1;
-	f24=1;
-	f25=1;
-	f26=1;
-	f27=1;
-	break;
-case 9:
-	f21=1;
-	f22=1;
-	f23=1;
-	f24=0;
-	f25=0;
-	f26=1;
-	f27=1;
-	break;
-default:
-	break;
 }
-switch(b)
+
+/* Render the scene with openGL */
+/* Times what follows as scope, until the next one, when the profiler is on */
+void profile (const RenderFrame* frame, int scope)
 {
-case 0:
-	f11=1;
-	f12=1;
-	f13=1;
-	f14=1;
-	f15=1;
-	f16=1;
-	f17=0;
-	break;
-case 1:
-	f11=1;
-	f12=1;
-	f13=1;
-	f14=1;
-	f15=1;
-	f16=1;
-	f17=0;
-	break;
-case 2:
-	f11=1;
-	f12=1;
-	f13=0;
-	f14=1;
-	f15=1;
-	f16=0;
-	f17=1;
-	break;
-case 3:
-	f11=1;
-	f12=1;
-	f13=1;
-	f14=1;
-	f15=0;
-	f16=0;
-	f17=1;
-	break;
-case 4:
-	f11=0;
-	f12=1;
-	f13=1;
-	f14=0;
-	f15=0;
-	f16=1;
-	f17=1;
-	break;
-case 5:
-	f11=1;
-	f12=0;
-	f13=1;
-	f14=1;
-	f15=0;
-	f16=1;
-	f17=1;
-	break;
-case 6:
-	f11=1;
-	f12=0;
-	f13=1;
-	f14=1;
-	f15=1;
-	f16=1;
-	f17=1;
-	break;
-case 7:
-	f11=1;
-	f12=1;
-	f13=1;
-	f14=0;
-	f15=0;
-	f16=0;
-	f17=0;
-	break;
-case 8:
-	f11=1;
-	f12=1;
-	f13=1;
-	f14=1;
-	f15=1;
-	f16=1;
-	f17=1;
-	break;
-case 9:
-	f11=1;
-	f12=1;
-	f13=1;
-	f14=0;
-	f15=0;
-	f16=1;
-	f17=1;
-	break;
-default:
-	break;
+	if(frame->profiling)
+		beginScope(&profiler, scope);
 }
 
-if(f24)
+/* Draws a recorded frame; runs on the render thread, which owns the context.
+ * False if there was nothing to draw and the buffer was left as it was. */
+bool render (const RenderFrame* frame)
 {
-/*scorehorizontal1*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate1 = glm::translate (glm::vec3(6.2, 6.3, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate1);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorehorizontal);}
-if(f27){
-/*scorehorizontal2*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate2 = glm::translate (glm::vec3(6.3, 6.9, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate2);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorehorizontal);}
-if(f21){
-/*scorehorizontal3*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate3 = glm::translate (glm::vec3(6.2, 7.5, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate3);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorehorizontal);}
-if(f25){
-/*scorevertical1*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate11 = glm::translate (glm::vec3(6.1, 6.4, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate11);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorevertical);}
-if(f26){
-/*scorevertical2*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate12= glm::translate (glm::vec3(6.1, 7.0, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate12);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorevertical);}
-if(f23){
-/*scorevertical4*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate14 = glm::translate (glm::vec3(6.8, 6.4, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate14);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorevertical);}
-if(f22){
-/*scorevertical3*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate13= glm::translate (glm::vec3(6.8, 7.0, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate13);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorevertical);}
-if(f14){
-/*scorehorizontal4*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate4 = glm::translate (glm::vec3(7.2, 6.3, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate4);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorehorizontal);}
-if(f17){
-/*scorehorizontal5*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate5 = glm::translate (glm::vec3(7.2, 6.9, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate5);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorehorizontal);}
-if(f11){
-/*scorehorizontal6*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate6 = glm::translate (glm::vec3(7.2, 7.5, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate6);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorehorizontal);}
-if(f15){
-/*scorevertical21*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate21 = glm::translate (glm::vec3(7.1, 6.4, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate21);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorevertical);}
-if(f16){
-/*scorevertical22*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate22= glm::translate (glm::vec3(7.1, 7.0, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate22);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorevertical);}
-if(f13){
-/*scorevertical24*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate24 = glm::translate (glm::vec3(7.8, 6.4, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate24);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorevertical);}
-if(f12){
-/*scorevertical23*/ Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translate23= glm::translate (glm::vec3(7.8, 7.0, 0));        // glTranslatef
-  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translate23);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(scorevertical);}
-if(negativeflag){
-	/*negative*/ Matrices.model = glm::mat4(1.0f);
-
-	  glm::mat4 translate5 = glm::translate (glm::vec3(5.4, 6.9, 0));        // glTranslatef
-	  //glm::mat4 rotateBasket1 = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-	  Matrices.model *= (translate5);
-	  MVP = VP * Matrices.model;
-	  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-draw3DObject(scorehorizontal);
-}
-	  // draw3DObject draws the VAO given to it using current MVP matrix
-
-  // Load identity to model matrix
-/*  Matrices.model = glm::mat4(1.0f);
-  Render your scene
-
-  glm::mat4 translateTriangle = glm::translate (glm::vec3(-2.0f, 0.0f, 0.0f)); // glTranslatef
-  glm::mat4 rotateTriangle = glm::rotate((float)(triangle_rotation*M_PI/180.0f), glm::vec3(0,0,1));  // rotate about vector (1,0,0)
-  glm::mat4 triangleTransform = translateTriangle * rotateTriangle;
-  Matrices.model *= triangleTransform;
-  MVP = VP * Matrices.model; // MVP = p * V * M
-
-  //  Don't change unless you are sure!!
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(triangle);
-
-  // Pop matrix to undo transformations till last push matrix instead of recomputing model matrix
-  // glPopMatrix ();
-  Matrices.model = glm::mat4(1.0f);
-
-  glm::mat4 translateRectangle = glm::translate (glm::vec3(2, 0, 0));        // glTranslatef
-  glm::mat4 rotateRectangle = glm::rotate((float)(rectangle_rotation*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-  Matrices.model *= (translateRectangle * rotateRectangle);
-  MVP = VP * Matrices.model;
-  glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-  // draw3DObject draws the VAO given to it using current MVP matrix
-  draw3DObject(rectangle);
-*/
-  // Increment angles
-	Matrices.model = glm::mat4(1.0f);
-	glm::mat4 translateline = glm::translate (glm::vec3(0, -6.0, 0));        // glTranslatef
-	glm::mat4 rotateline = glm::rotate((float)(0*M_PI/180.0f), glm::vec3(0,0,1)); // rotate about vector (-1,1,1)
-	Matrices.model *= (translateline * rotateline);
-	MVP = VP * Matrices.model;
-		glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-	draw3DObject(line);
+	TRACE_SCOPE("render");
+	if(!frame->running)
+		return false;
+	if(frame->width != hudwidth || frame->height != hudheight)
+		resizeViewport(frame->width, frame->height);
+	beginRenderTarget(&rendertarget, frame->width, frame->height, frame->renderscale);
 
-  float increments = 1;
+  // clear the color and depth in the frame buffer
+  glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  // use the loaded shader program
+  // Don't change unless you know what you are doing
+  if (!linked)
+    linkProgram();
+  useProgram(programID);
+  // View-projection only changes with pan and zoom; it is uploaded to
+  // the camera block then and left alone otherwise
+  setCameraView(&camera, &frame->view);
+  updateCamera(&camera);
+  viewRect(&frame->view, viewrect);
+
+	if(frame->profiling)
+		beginProfileFrame(&profiler);
+	for(int i=0;i<=frame->nobjects;i++)
+	{
+		if(i == frame->brickorder)
+		{
+			profile(frame, SCOPE_BRICKS);
+			drawBricks(frame);
+		}
+		if(i < frame->nobjects)
+		{
+			profile(frame, frame->objects[i].scope);
+			renderObject(frame, &frame->objects[i]);
+		}
+	}
 
-  //camera_rotation_angle++; // Simulating camera rotation
-  triangle_rotation = triangle_rotation + increments*triangle_rot_dir*triangle_rot_status;
-  rectangle_rotation = rectangle_rotation + increments*rectangle_rot_dir*rectangle_rot_status;
-}
+	if(frame->batching)
+	{
+		profile(frame, SCOPE_SPRITES);
+		flushSprites(&sprites);
+	}
+	profile(frame, SCOPE_SCORE);
+	setScore(&scoreboard, frame->points);
+	drawScore(&scoreboard);
+	profile(frame, SCOPE_HUD);
+	resolveRenderTarget(&rendertarget);
+	drawHud(frame);
+	if(frame->profiling)
+		endProfileFrame(&profiler);
+	return true;
 }
 
 /* Initialise glfw window, I/O callbacks and the renderer to use */
 /* Nothing to Edit here */
 GLFWwindow* initGLFW (int width, int height)
 {
+    TRACE_SCOPE("initGLFW");
     GLFWwindow* window; // window desciptor/handle
 
     glfwSetErrorCallback(error_callback);
@@ -1690,6 +1296,19 @@ GLFWwindow* initGLFW (int width, int height)
 /* Add all the models to be created here */
 void initGL (GLFWwindow* window, int width, int height)
 {
+	TRACE_SCOPE("initGL");
+	// a new context: everything at its default
+	resetGLState();
+
+	// Start every GLSL program before anything else, so the driver can
+	// compile them side by side while the models are built
+	initShaderManager();
+	programID = submitProgram( "Sample_GL.vert", "Sample_GL.frag" );
+	spriteprogramID = submitProgram( "Sprite_GL.vert", "Sample_GL.frag" );
+	GLuint scoreprogramID = submitProgram( "Score_GL.vert", "Sample_GL.frag" );
+	GLuint textprogramID = submitProgram( "Text_GL.vert", "Text_GL.frag" );
+	linked = false;
+
     /* Objects should be created before any other gl function and shaders
 	// Create the models
 	createTriangle (); // Generate the VAO, VBOs, vertices data & copy into the array buffer
@@ -1698,32 +1317,35 @@ createRedbox();
 createGreenbox();
 createlaser1();
 createlaser2();
-if(laserflag==0)
+if(game.laserflag==0)
 	createlaser();
 createBrick1();
-createBrick2();
-createBrick3();
+createBrickBatch();
 
 createline();
 createmirror1();
 createmirror2();
-createscorehorizontal();
-createscorevertical();
 
 //laser_xlength ++;
-	// Create and compile our GLSL program from the shaders
-	programID = LoadShaders( "Sample_GL.vert", "Sample_GL.frag" );
-	// Get a handle for our "MVP" uniform
-	Matrices.MatrixID = glGetUniformLocation(programID, "MVP");
+	initCamera(&camera);
+	initSpriteBatch(&sprites, spriteprogramID);
+
+	// the score sits at the top right, two digits at least
+	initScoreWidget(&scoreboard, scoreprogramID, 7.1, 6.3, 2);
+	initTextBatch(&hudtext, textprogramID);
+	initProfiler(&profiler, scopenames, NSCOPES);
+	initFrameTimer(&frametimer);
 
 
+	initCameraView(&view);
+	initRenderQueue(&renderqueue);
 	reshapeWindow (window, width, height);
 
     // Background color of the scene
 	glClearColor (0.0f, 1.0f, 1.0f, 0.0f); // R, G, B, A
 	glClearDepth (1.0f);
 
-	glEnable (GL_DEPTH_TEST);
+	setCapability(GL_DEPTH_TEST, true);
 	glDepthFunc (GL_LEQUAL);
 
     cout << "VENDOR: " << glGetString(GL_VENDOR) << endl;
@@ -1732,46 +1354,241 @@ createscorevertical();
     cout << "GLSL: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << endl;
 }
 
+/* Frame to frame time, then what the simulation, drawing and the swap took */
+void printFrameTimes ()
+{
+    printTimeHistogram(&frametimes, stdout);
+    printTimeHistogram(&simtimes, stdout);
+    printTimeHistogram(&rendertimes, stdout);
+    printTimeHistogram(&presenttimes, stdout);
+}
+
+/* The render thread: draws the frames the simulation records, in order */
+void renderLoop (GLFWwindow* window)
+{
+    nameTraceThread("render");
+    initTimeHistogram(&frametimes, "frame");
+    initTimeHistogram(&simtimes, "sim");
+    initTimeHistogram(&rendertimes, "render");
+    initTimeHistogram(&presenttimes, "present");
+    if (headless)
+        makeHeadlessCurrent(true);
+    else
+        glfwMakeContextCurrent(window);
+    double last_frame_start = 0;
+    bool capturing = capturepath && startCapture(&capture, capturepath, framewidth, frameheight);
+    RenderFrame* frame;
+    long long int frameno = 0;
+    initRenderTarget(&rendertarget);
+    while ((frame = nextFrame(&renderqueue))) {
+        double framestart = clockTime();
+        if (last_frame_start > 0) {
+            frametime += (framestart - last_frame_start - frametime)*0.1;
+            recordTime(&frametimes, framestart - last_frame_start);
+        }
+        last_frame_start = framestart;
+
+        // OpenGL Draw commands; a frame that draws nothing is not shown,
+        // the window keeps the last one. Offscreen the framebuffer still
+        // holds it, so the video goes on at one frame per tick.
+        beginFrameTimer(&frametimer);
+        bool drawn = render(frame);
+        if (capturing && (drawn || headless))
+            captureFrame(&capture, headless ? frameno*GAME_TICK : framestart);
+        endFrameTimer(&frametimer);
+        frameno++;
+        endGLStateFrame();
+        endRenderStatsFrame();
+        double rendertime = clockTime() - framestart;
+        // a GPU-bound frame is only slow on the GPU side, and in the swap
+        frame->rendertime = max(rendertime, frametimer.gpu);
+        recordTime(&simtimes, frame->simtime);
+        recordTime(&rendertimes, rendertime);
+        bool report = frame->reporttimes;
+        // the slot is free to record into while the swap waits
+        releaseFrame(&renderqueue);
+
+        // Swap Frame Buffer in double buffering
+        double presentstart = clockTime();
+        {
+            TRACE_SCOPE("swapBuffers");
+            if (headless)
+                finishHeadlessFrame();
+            else if (drawn)
+                glfwSwapBuffers(window);
+        }
+        if (drawn)
+            recordTime(&presenttimes, clockTime() - presentstart);
+        if (report)
+            printFrameTimes();
+    }
+    printFrameTimes();
+    if (capturing) {
+        stopCapture(&capture, headless ? frameno*GAME_TICK : clockTime());
+        printf("Capture: %lld video frames to %s from %d drawn, %d dropped, waited %d times\n",
+            capture.slots, capturepath, capture.captured, capture.dropped, capture.waits);
+    }
+    if (headless) {
+        if (shotpath && !saveHeadlessFrame(shotpath))
+            fprintf(stderr, "Can't write %s\n", shotpath);
+        makeHeadlessCurrent(false);
+    }
+    else
+        glfwMakeContextCurrent(NULL);
+}
+
 int main (int argc, char** argv)
 {
 	int width = 800;
 	int height = 800;
-	laserflag=0;
+	initGame(&game, time(NULL));
 //	speed[1]= 0.01, speed[2]= 0.013, speed[3]= 0.016 ,speed[4]=0.008, speed[5]= 0.015, speed[6]= 0.011, speed[7]= 0.012, speed[8]= ;
 int i ;
-for(i=0;i<10;i++)
+double budget = 4; // ms of sim + render per frame, 0 turns the governor off
+const char* scriptpath = NULL;
+int maxframes = 0; // stop after this many frames, 0 = when the window closes
+int statsevery = 0; // print the render counters every this many frames
+const char* statspath = NULL;
+FILE* statsfile = NULL;
+for(i=1;i<argc;i++)
+{
+	if(!strcmp(argv[i], "--stack"))
+		game.stackmode=1;
+	else if(!strcmp(argv[i], "--spawners") && i+1<argc)
+		game.nspawners=atoi(argv[++i]);
+	else if(!strcmp(argv[i], "--budget") && i+1<argc)
+		budget=atof(argv[++i]);
+	else if(!strcmp(argv[i], "--script") && i+1<argc)
+		scriptpath=argv[++i];
+	else if(!strcmp(argv[i], "--assets") && i+1<argc)
+		setAssetDir(argv[++i]);
+	else if(!strcmp(argv[i], "--headless"))
+		headless=true;
+	else if(!strcmp(argv[i], "--frames") && i+1<argc)
+		maxframes=atoi(argv[++i]);
+	else if(!strcmp(argv[i], "--shot") && i+1<argc)
+		shotpath=argv[++i];
+	else if(!strcmp(argv[i], "--capture") && i+1<argc)
+		capturepath=argv[++i];
+	else if(!strcmp(argv[i], "--seed") && i+1<argc)
+		game.seed=strtoul(argv[++i], NULL, 10);
+	else if(!strcmp(argv[i], "--trace") && i+1<argc)
+		startTrace(argv[++i]);
+	else if(!strcmp(argv[i], "--stats") && i+1<argc)
+		statsevery=atoi(argv[++i]);
+	else if(!strcmp(argv[i], "--stats-json") && i+1<argc)
+		statspath=argv[++i];
+}
+if(statspath)
 {
-	flag[i]=0;
-	brick_y[i]=10;
+	statsfile=fopen(statspath, "w");
+	if(!statsfile)
+		fprintf(stderr, "Can't write %s\n", statspath);
+	else if(statsevery<=0)
+		statsevery=60;
 }
-speedlower = 0.03 ;
-speedupper = 0.06 ;
-    GLFWwindow* window = initGLFW(width, height);
+reportRenderStats(statsevery, statsfile);
+nameTraceThread("main");
+if(game.seed==0)
+	game.seed=1;
+// a headless run has nobody to close it
+if(headless && maxframes<=0)
+	maxframes=600;
+if(scriptpath && loadBrickScript(scriptpath, &levelscript))
+	attachBrickScript(&game.vm, &levelscript, game.seed);
+if(game.nspawners<1)
+	game.nspawners=1;
+if(game.nspawners>MAX_SPAWNERS)
+	game.nspawners=MAX_SPAWNERS;
+game.activespawners=game.nspawners;
+scalesteps = headless ? 0 : RENDER_SCALE_STEPS;
+int maxlevel=scalesteps;
+while((game.nspawners>>(maxlevel-scalesteps)) > 9)
+	maxlevel++;
+initGovernor(&governor, budget/1000, maxlevel);
+    GLFWwindow* window = NULL;
+    if (headless) {
+        if (!initHeadless(width, height))
+            return 1;
+    }
+    else
+        window = initGLFW(width, height);
 
-	initGL (window, width, height);
+    initGL (window, width, height);
 
-    double last_update_time = glfwGetTime(), current_time;
+    // From here on GL is only used by the render thread; this one runs
+    // the game and hands it frames through the render queue
+    if (headless)
+        makeHeadlessCurrent(false);
+    else
+        glfwMakeContextCurrent(NULL);
+    std::thread renderer(renderLoop, window);
+
+    double current_time;
+    double last_tick_time = clockTime();
+    double start_time = clockTime();
+    int frames = 0;
 
     /* Draw in loop */
-    while (!glfwWindowShouldClose(window)) {
+    while (headless || !glfwWindowShouldClose(window)) {
+        if (maxframes > 0 && frames == maxframes)
+            break;
 
-        // OpenGL Draw commands
-        draw(window);
+        // once the game is over nothing moves until a key restarts it, so
+        // rather than record frames that draw nothing, sleep until an
+        // event comes in, and record one only if it may change the picture
+        // (a HUD toggle, a resize); headless runs keep one frame per tick
+        if (!headless && game.gameflag != 0 && !redraw) {
+            TRACE_SCOPE("waitEvents");
+            glfwWaitEventsTimeout(IDLE_WAIT);
+            // the time asleep is not played back as a burst of ticks
+            last_tick_time = clockTime();
+            continue;
+        }
 
-        // Swap Frame Buffer in double buffering
-        glfwSwapBuffers(window);
+        // waits while the render thread is a frame behind
+        RenderFrame* frame = recordFrame(&renderqueue);
+        if (!frame)
+            break;
+        current_time = clockTime();
+        // headless, every frame is one tick, however long it takes to draw,
+        // so a run with the same --seed draws the same frames
+        if (headless)
+            ticklag += GAME_TICK;
+        else
+            ticklag += current_time - last_tick_time;
+        last_tick_time = current_time;
+        // after a stall the game slows down for a moment rather than jump
+        if (ticklag > MAX_CATCHUP_TICKS*GAME_TICK)
+            ticklag = MAX_CATCHUP_TICKS*GAME_TICK;
+        simtime = 0;
+        update(window, frame);
+        redraw = false;
+        // the render time is that of the frame drawn from this slot before
+        governLoad(frame->rendertime);
+        submitFrame(&renderqueue);
+        frames++;
 
         // Poll for Keyboard and mouse events
-        glfwPollEvents();
-
-        // Control based on time (Time based transformation like 5 degrees rotation every 0.5s)
-        current_time = glfwGetTime(); // Time in seconds
-       if ((current_time - last_update_time) >= 0.1) { // atleast 0.5s elapsed since last frame
-            // do something every 0.5 seconds ..
-            last_update_time = current_time;
+        if (!headless) {
+            TRACE_SCOPE("pollEvents");
+            glfwPollEvents();
         }
     }
 
-    glfwTerminate();
+    closeRenderQueue(&renderqueue);
+    renderer.join();
+    writeTrace();
+    if (statsfile)
+        fclose(statsfile);
+    if (headless) {
+        double seconds = clockTime() - start_time;
+        printf("Headless: %d frames in %.2f s, %.1f fps\n", frames, seconds, seconds > 0 ? frames/seconds : 0);
+        closeHeadless();
+    }
+    else {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 //    exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,44 @@
+#version 330 core
+
+// input data : sent from main program
+layout (location = 0) in vec2 digitPlace;     // lower left corner; one per digit
+layout (location = 1) in uint digitSegments;  // bit 0 is segment a ... bit 6 is segment g
+
+layout (std140) uniform Camera {
+    mat4 VP;
+};
+uniform vec3 Color;
+
+// output data : used by fragment shader
+out vec3 fragColor;
+
+// lower left corner and size of the segments a to g in a digit
+const vec4 segment[7] = vec4[7](
+    vec4(0.1, 1.2, 0.4, 0.1),    // a top
+    vec4(0.7, 0.7, 0.07, 0.4),   // b upper right
+    vec4(0.7, 0.1, 0.07, 0.4),   // c lower right
+    vec4(0.1, 0.0, 0.4, 0.1),    // d bottom
+    vec4(0.0, 0.1, 0.07, 0.4),   // e lower left
+    vec4(0.0, 0.7, 0.07, 0.4),   // f upper left
+    vec4(0.1, 0.6, 0.4, 0.1)     // g middle
+);
+
+const vec2 corner[6] = vec2[6](
+    vec2(0, 0), vec2(1, 0), vec2(1, 1),
+    vec2(1, 1), vec2(0, 1), vec2(0, 0)
+);
+
+void main ()
+{
+    int s = gl_VertexID / 6;
+    vec2 p = segment[s].xy + segment[s].zw * corner[gl_VertexID % 6];
+
+    // A segment that is off collapses to a point and covers no pixels
+    if (((digitSegments >> uint(s)) & 1u) == 0u)
+        p = vec2(0);
+
+    fragColor = Color;
+
+    // Output position of the vertex, in clip space : VP * position
+    gl_Position = VP * vec4(digitPlace + p, 0, 1);
+}
@@ -0,0 +1,27 @@
+#version 330 core
+
+// input data : sent from main program
+layout (location = 0) in vec2 corner;        // corner of the unit quad, 0 or 1 in x and y
+layout (location = 1) in vec4 spritePlace;   // x, y, rotation, depth; one per sprite
+layout (location = 2) in vec4 spriteRect;    // min x, min y, max x, max y
+layout (location = 3) in vec4 spriteColor;
+
+layout (std140) uniform Camera {
+    mat4 VP;
+};
+
+// output data : used by fragment shader
+out vec3 fragColor;
+
+void main ()
+{
+    // Stretch the unit quad over the rectangle, turn it and move it in place
+    vec2 p = mix(spriteRect.xy, spriteRect.zw, corner);
+    float c = cos(spritePlace.z), s = sin(spritePlace.z);
+    p = vec2(c*p.x - s*p.y, s*p.x + c*p.y) + spritePlace.xy;
+
+    fragColor = spriteColor.rgb;
+
+    // Output position of the vertex, in clip space : VP * position
+    gl_Position = VP * vec4(p, spritePlace.w, 1);
+}
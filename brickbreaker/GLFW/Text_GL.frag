@@ -0,0 +1,22 @@
+#version 330 core
+
+// Interpolated values from the vertex shaders
+in vec2 atlasCoord;
+in vec4 textColor;
+
+uniform sampler2D Atlas;   // distance field, 0.5 on the edge of a stroke
+
+// output data
+out vec4 color;
+
+void main()
+{
+    // Cut the edge where the field crosses 0.5, smoothed over about a pixel
+    // whatever the size the glyph is drawn at
+    float d = texture(Atlas, atlasCoord).r;
+    float w = max(fwidth(d) * 0.75, 1e-4);
+    float a = smoothstep(0.5 - w, 0.5 + w, d);
+    if (a == 0.0)
+        discard;
+    color = vec4(textColor.rgb, textColor.a * a);
+}
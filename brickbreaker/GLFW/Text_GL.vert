@@ -0,0 +1,33 @@
+#version 330 core
+
+// input data : sent from main program
+layout (location = 0) in vec4 glyphPlace;   // x, y, size, character; one per glyph
+layout (location = 1) in vec4 glyphColor;
+
+uniform mat4 VP;
+uniform vec4 CellBox;     // a glyph's atlas cell around its origin, in sizes
+uniform vec2 AtlasGrid;   // cells across and down the atlas
+
+// output data : used by fragment shader
+out vec2 atlasCoord;
+out vec4 textColor;
+
+const vec2 corner[6] = vec2[6](
+    vec2(0, 0), vec2(1, 0), vec2(1, 1),
+    vec2(1, 1), vec2(0, 1), vec2(0, 0)
+);
+
+void main ()
+{
+    vec2 c = corner[gl_VertexID];
+    vec2 p = glyphPlace.xy + mix(CellBox.xy, CellBox.zw, c) * glyphPlace.z;
+
+    // ASCII 32 is the first cell, the atlas is filled row by row
+    int code = int(glyphPlace.w) - 32;
+    vec2 cell = vec2(code % int(AtlasGrid.x), code / int(AtlasGrid.x));
+    atlasCoord = (cell + c) / AtlasGrid;
+    textColor = glyphColor;
+
+    // Output position of the vertex, in clip space : VP * position
+    gl_Position = VP * vec4(p, 0, 1);
+}
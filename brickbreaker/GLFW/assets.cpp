@@ -0,0 +1,34 @@
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "assets.h"
+#include "embedded_assets.h"
+
+static const char* assetdir = NULL;
+
+void setAssetDir (const char* dir)
+{
+	assetdir = dir;
+}
+
+bool loadAsset (const char* name, std::string* contents)
+{
+	if(assetdir)
+	{
+		std::string path = std::string(assetdir) + "/" + name;
+		std::ifstream stream(path.c_str(), std::ios::in | std::ios::binary);
+		if(!stream.is_open())
+			return false;
+		contents->assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+		return true;
+	}
+	for(size_t i=0; i<sizeof embeddedassets/sizeof embeddedassets[0]; i++)
+	{
+		if(strcmp(embeddedassets[i].name, name) == 0)
+		{
+			contents->assign(embeddedassets[i].data);
+			return true;
+		}
+	}
+	return false;
+}
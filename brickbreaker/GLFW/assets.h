@@ -0,0 +1,22 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <string>
+
+/* Files the game needs at run time (shaders for now) are compiled into the
+ * binary by embed.sh, listed as ASSETS in the Makefile, so the game starts
+ * from any directory without opening a file. For working on them, --assets
+ * DIR reads them from DIR instead, on every load. */
+
+struct EmbeddedAsset {
+	const char* name;
+	const char* data;
+};
+
+/* Reads assets from dir instead of the built in copies; NULL goes back to those */
+void setAssetDir (const char* dir);
+
+/* Contents of the named asset; false if there is no such asset */
+bool loadAsset (const char* name, std::string* contents);
+
+#endif
@@ -0,0 +1,93 @@
+#include "brickpool.h"
+
+void initBrickPool (BrickPool* pool)
+{
+	pool->count = 0;
+	pool->nfree = BRICK_POOL_CAPACITY;
+	for(int s=0; s<BRICK_POOL_CAPACITY; s++)
+	{
+		pool->dense[s] = -1;
+		pool->generation[s] = 0;
+		// lowest slots on top of the stack so spawns fill the pool from slot 0
+		pool->freeslots[s] = BRICK_POOL_CAPACITY - 1 - s;
+	}
+}
+
+/* Pops a free slot and appends the brick to the end of the live range.
+ * Returns BRICK_NONE when the pool is full. */
+BrickHandle spawnBrick (BrickPool* pool, int type, int lane, float x, float y, float speed)
+{
+	if(pool->nfree == 0)
+		return BRICK_NONE;
+
+	int s = pool->freeslots[--pool->nfree];
+	int i = pool->count++;
+	BrickHandle h = ((BrickHandle)pool->generation[s] << 16) | (BrickHandle)s;
+
+	pool->x[i] = x;
+	pool->y[i] = y;
+	pool->prevx[i] = x;
+	pool->prevy[i] = y;
+	pool->speed[i] = speed;
+	pool->type[i] = type;
+	pool->lane[i] = lane;
+	pool->spawner[i] = -1;
+	pool->basket[i] = -1;
+	pool->handle[i] = h;
+	pool->dense[s] = i;
+	return h;
+}
+
+/* Removes the live brick at dense index i by moving the last live brick
+ * into its place. Handles of the other bricks stay valid. */
+void killBrick (BrickPool* pool, int i)
+{
+	int last = --pool->count;
+	int s = pool->handle[i] & 0xffff;
+
+	if(i != last)
+	{
+		pool->x[i] = pool->x[last];
+		pool->y[i] = pool->y[last];
+		pool->prevx[i] = pool->prevx[last];
+		pool->prevy[i] = pool->prevy[last];
+		pool->speed[i] = pool->speed[last];
+		pool->type[i] = pool->type[last];
+		pool->lane[i] = pool->lane[last];
+		pool->spawner[i] = pool->spawner[last];
+		pool->basket[i] = pool->basket[last];
+		pool->handle[i] = pool->handle[last];
+		pool->dense[pool->handle[i] & 0xffff] = i;
+	}
+
+	// bump the generation so stale handles to this slot stop resolving
+	pool->dense[s] = -1;
+	pool->generation[s]++;
+	pool->freeslots[pool->nfree++] = s;
+}
+
+/* Dense index of the brick behind h, or -1 if it has been killed */
+int brickIndex (const BrickPool* pool, BrickHandle h)
+{
+	if(h == BRICK_NONE)
+		return -1;
+	int s = h & 0xffff;
+	if(s >= BRICK_POOL_CAPACITY || pool->generation[s] != (h >> 16))
+		return -1;
+	return pool->dense[s];
+}
+
+void clearBrickPool (BrickPool* pool)
+{
+	while(pool->count > 0)
+		killBrick(pool, pool->count - 1);
+}
+
+void saveBrickPositions (BrickPool* pool)
+{
+	for(int i=0; i<pool->count; i++)
+	{
+		pool->prevx[i] = pool->x[i];
+		pool->prevy[i] = pool->y[i];
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef BRICKPOOL_H
+#define BRICKPOOL_H
+
+/* Pool of falling bricks.
+ * Live bricks are kept packed in [0, count) so every per-tick loop only
+ * touches bricks that are actually on screen. Removing a brick moves the
+ * last live brick into its place (swap-remove); code that needs to refer to
+ * a particular brick across ticks keeps a BrickHandle instead of an index. */
+
+#define BRICK_POOL_CAPACITY 4096
+
+enum BrickType { BRICK_BLACK = 0, BRICK_RED = 1, BRICK_GREEN = 2 };
+
+/* slot number in the low 16 bits, slot generation in the high 16 bits */
+typedef unsigned int BrickHandle;
+#define BRICK_NONE 0xffffffffu
+
+struct BrickPool {
+	int count;                                  // number of live bricks
+	float x[BRICK_POOL_CAPACITY];
+	float y[BRICK_POOL_CAPACITY];
+	float prevx[BRICK_POOL_CAPACITY];           // x, y before the last tick, to draw in between
+	float prevy[BRICK_POOL_CAPACITY];
+	float speed[BRICK_POOL_CAPACITY];
+	int type[BRICK_POOL_CAPACITY];
+	int lane[BRICK_POOL_CAPACITY];
+	int spawner[BRICK_POOL_CAPACITY];           // spawner that owns the brick, -1 if none
+	int basket[BRICK_POOL_CAPACITY];            // basket the brick has landed in, -1 while falling
+	BrickHandle handle[BRICK_POOL_CAPACITY];    // dense index -> handle
+
+	int dense[BRICK_POOL_CAPACITY];             // slot -> dense index, -1 when free
+	unsigned short generation[BRICK_POOL_CAPACITY];
+	int freeslots[BRICK_POOL_CAPACITY];         // stack of free slots
+	int nfree;
+};
+
+void initBrickPool (BrickPool* pool);
+BrickHandle spawnBrick (BrickPool* pool, int type, int lane, float x, float y, float speed);
+void killBrick (BrickPool* pool, int i);
+int brickIndex (const BrickPool* pool, BrickHandle h);
+void clearBrickPool (BrickPool* pool);
+
+/* Copies x, y of every live brick into prevx, prevy; called before a tick */
+void saveBrickPositions (BrickPool* pool);
+
+#endif
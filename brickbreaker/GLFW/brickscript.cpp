@@ -0,0 +1,429 @@
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include "brickscript.h"
+
+/* GCC and clang can take the address of a label, which lets every handler
+ * jump straight to the next one. Elsewhere the same handlers sit in a switch. */
+#if defined(__GNUC__)
+#define SCRIPT_THREADED 1
+#endif
+
+enum { ARG_NONE, ARG_VALUE, ARG_VAR };
+
+struct ScriptOpInfo {
+	const char* name;
+	int arg;
+	int pop, push;
+};
+
+static const ScriptOpInfo opinfo[NUM_SCRIPT_OPS] = {
+	{"end", ARG_NONE, 0, 0},
+	{"push", ARG_VALUE, 0, 1},
+	{"load", ARG_VAR, 0, 1},
+	{"store", ARG_VAR, 1, 0},
+	{"add", ARG_NONE, 2, 1},
+	{"sub", ARG_NONE, 2, 1},
+	{"mul", ARG_NONE, 2, 1},
+	{"div", ARG_NONE, 2, 1},
+	{"mod", ARG_NONE, 2, 1},
+	{"min", ARG_NONE, 2, 1},
+	{"max", ARG_NONE, 2, 1},
+	{"lt", ARG_NONE, 2, 1},
+	{"neg", ARG_NONE, 1, 1},
+	{"abs", ARG_NONE, 1, 1},
+	{"floor", ARG_NONE, 1, 1},
+	{"sin", ARG_NONE, 1, 1},
+	{"cos", ARG_NONE, 1, 1},
+	{"rand", ARG_NONE, 0, 1},
+	{"dup", ARG_NONE, 1, 2},
+	{"swap", ARG_NONE, 2, 2},
+	{"sel", ARG_NONE, 3, 1},
+};
+
+static const char* varnames[NUM_SCRIPT_VARS] = {
+	"x", "y", "speed", "type", "r0", "r1", "r2", "r3",
+	"age", "id", "x0", "y0",
+	"tick", "wave", "count",
+};
+
+static int lookup (const char* word, const char* const* names, int n)
+{
+	for(int k=0; k<n; k++)
+		if(!strcmp(word, names[k]))
+			return k;
+	return -1;
+}
+
+static int scriptError (const char* path, int line, const char* msg, const char* word)
+{
+	fprintf(stderr, "%s:%d: %s %s\n", path, line, msg, word ? word : "");
+	return 0;
+}
+
+/* One instruction per line, '#' starts a comment. Stack depths are checked
+ * here so the interpreter never has to. */
+int loadBrickScript (const char* path, BrickScript* script)
+{
+	FILE* f = fopen(path, "r");
+	if(!f)
+	{
+		fprintf(stderr, "Impossible to open %s\n", path);
+		return 0;
+	}
+
+	script->count = 1;
+	script->every = 60;
+	script->waves = 0;
+	ScriptCell* code = NULL;
+	int len[2] = {0, 0};
+	int depth = 0, ok = 1, line = 0;
+	char buf[256];
+	const char* names[NUM_SCRIPT_OPS];
+	for(int k=0; k<NUM_SCRIPT_OPS; k++)
+		names[k] = opinfo[k].name;
+
+	while(ok && fgets(buf, sizeof buf, f))
+	{
+		line++;
+		char* hash = strchr(buf, '#');
+		if(hash)
+			*hash = 0;
+		char word[64], arg[64];
+		int nwords = sscanf(buf, "%63s %63s", word, arg);
+		if(nwords < 1)
+			continue;
+
+		if(!strcmp(word, "spawn:") || !strcmp(word, "tick:"))
+		{
+			if(code && depth != 0)
+				ok = scriptError(path, line, "values left on the stack before", word);
+			code = word[0] == 's' ? script->spawn : script->tick;
+			depth = 0;
+			continue;
+		}
+		if(!code)
+		{
+			int *setting = !strcmp(word, "count") ? &script->count : !strcmp(word, "every") ? &script->every
+					: !strcmp(word, "waves") ? &script->waves : NULL;
+			if(!setting || nwords < 2)
+				ok = scriptError(path, line, "unknown setting", word);
+			else
+				*setting = atoi(arg);
+			continue;
+		}
+
+		int *n = &len[code == script->tick];
+		int op = lookup(word, names, NUM_SCRIPT_OPS);
+		if(op <= OP_END)
+		{
+			ok = scriptError(path, line, "unknown instruction", word);
+			continue;
+		}
+		if(depth < opinfo[op].pop)
+		{
+			ok = scriptError(path, line, "stack underflow at", word);
+			continue;
+		}
+		depth += opinfo[op].push - opinfo[op].pop;
+		if(depth > SCRIPT_STACK)
+		{
+			ok = scriptError(path, line, "stack overflow at", word);
+			continue;
+		}
+		if(*n + 3 > SCRIPT_MAX_CODE)
+		{
+			ok = scriptError(path, line, "program too long at", word);
+			continue;
+		}
+		code[(*n)++].op = op;
+		if(opinfo[op].arg == ARG_NONE)
+			continue;
+		if(nwords < 2)
+		{
+			ok = scriptError(path, line, "missing operand for", word);
+			continue;
+		}
+		if(opinfo[op].arg == ARG_VALUE)
+		{
+			char* end;
+			code[(*n)++].value = strtof(arg, &end);
+			if(*end)
+				ok = scriptError(path, line, "not a number:", arg);
+			continue;
+		}
+		int var = lookup(arg, varnames, NUM_SCRIPT_VARS);
+		if(var < 0)
+			ok = scriptError(path, line, "unknown variable", arg);
+		else if(op == OP_STORE && var > VAR_LAST_STORE)
+			ok = scriptError(path, line, "read only variable", arg);
+		code[(*n)++].var = var;
+	}
+	fclose(f);
+	if(ok && code && depth != 0)
+		ok = scriptError(path, line, "values left on the stack at the end", NULL);
+	if(ok && (script->count < 1 || script->count > BRICK_POOL_CAPACITY || script->every < 1))
+		ok = scriptError(path, line, "count must be 1 to 4096 and every at least 1", NULL);
+	script->spawn[len[0]].op = OP_END;
+	script->tick[len[1]].op = OP_END;
+	return ok;
+}
+
+static float scriptRand (ScriptVM* vm)
+{
+	unsigned int x = vm->seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	vm->seed = x;
+	return (x >> 8) * (1.0f/16777216);
+}
+
+/* Runs code over the vm->n bricks in vm->index[]. Called with a table
+ * pointer instead, it only hands out the handler addresses. */
+static void execute (ScriptVM* vm, BrickPool* pool, const ScriptCell* code, const void* const** table)
+{
+	const int n = vm->n;
+	const ScriptCell* pc = code;
+	int sp = 0;
+	int k;
+
+#ifdef SCRIPT_THREADED
+	static const void* const handlers[NUM_SCRIPT_OPS] = {
+		&&op_end, &&op_push, &&op_load, &&op_store,
+		&&op_add, &&op_sub, &&op_mul, &&op_div, &&op_mod, &&op_min, &&op_max, &&op_lt,
+		&&op_neg, &&op_abs, &&op_floor, &&op_sin, &&op_cos,
+		&&op_rand, &&op_dup, &&op_swap, &&op_sel,
+	};
+	if(table)
+	{
+		*table = handlers;
+		return;
+	}
+#define HANDLER(op, label) label:
+#define NEXT goto *(pc++)->handler
+	NEXT;
+#else
+	if(table)
+	{
+		*table = NULL;
+		return;
+	}
+#define HANDLER(op, label) case op:
+#define NEXT break
+	for(;;) switch((pc++)->op) {
+#endif
+
+// a and b are the two topmost vectors, b on top; binary ops leave their result in a
+#define BINARY(op, label, expr) HANDLER(op, label) { \
+		float* b = vm->stack[--sp]; float* a = vm->stack[sp-1]; \
+		for(k=0; k<n; k++) a[k] = (expr); \
+		NEXT; }
+#define UNARY(op, label, expr) HANDLER(op, label) { \
+		float* a = vm->stack[sp-1]; \
+		for(k=0; k<n; k++) a[k] = (expr); \
+		NEXT; }
+
+	HANDLER(OP_END, op_end)
+		return;
+
+	HANDLER(OP_PUSH, op_push) {
+		float v = (pc++)->value;
+		float* d = vm->stack[sp++];
+		for(k=0; k<n; k++) d[k] = v;
+		NEXT; }
+
+	HANDLER(OP_LOAD, op_load) {
+		int var = (pc++)->var;
+		float* d = vm->stack[sp++];
+		const int* idx = vm->index;
+		const int* slot = vm->slot;
+		switch(var)
+		{
+			case VAR_X: for(k=0; k<n; k++) d[k] = pool->x[idx[k]]; break;
+			case VAR_Y: for(k=0; k<n; k++) d[k] = pool->y[idx[k]]; break;
+			case VAR_SPEED: for(k=0; k<n; k++) d[k] = pool->speed[idx[k]]; break;
+			case VAR_TYPE: for(k=0; k<n; k++) d[k] = pool->type[idx[k]]; break;
+			case VAR_AGE: for(k=0; k<n; k++) d[k] = vm->age[slot[k]]; break;
+			case VAR_ID: for(k=0; k<n; k++) d[k] = vm->id[slot[k]]; break;
+			case VAR_X0: for(k=0; k<n; k++) d[k] = vm->x0[slot[k]]; break;
+			case VAR_Y0: for(k=0; k<n; k++) d[k] = vm->y0[slot[k]]; break;
+			case VAR_TICK: for(k=0; k<n; k++) d[k] = vm->ticks; break;
+			case VAR_WAVE: for(k=0; k<n; k++) d[k] = vm->wave; break;
+			case VAR_COUNT: for(k=0; k<n; k++) d[k] = vm->script->count; break;
+			default: {
+				const float* r = vm->reg[var - VAR_R0];
+				for(k=0; k<n; k++) d[k] = r[slot[k]];
+			}
+		}
+		NEXT; }
+
+	HANDLER(OP_STORE, op_store) {
+		int var = (pc++)->var;
+		const float* s = vm->stack[--sp];
+		const int* idx = vm->index;
+		const int* slot = vm->slot;
+		switch(var)
+		{
+			case VAR_X: for(k=0; k<n; k++) pool->x[idx[k]] = s[k]; break;
+			case VAR_Y: for(k=0; k<n; k++) pool->y[idx[k]] = s[k]; break;
+			case VAR_SPEED: for(k=0; k<n; k++) pool->speed[idx[k]] = s[k]; break;
+			case VAR_TYPE: for(k=0; k<n; k++) pool->type[idx[k]] = ((int)floorf(s[k]) % 3 + 3) % 3; break;
+			default: {
+				float* r = vm->reg[var - VAR_R0];
+				for(k=0; k<n; k++) r[slot[k]] = s[k];
+			}
+		}
+		NEXT; }
+
+	BINARY(OP_ADD, op_add, a[k] + b[k])
+	BINARY(OP_SUB, op_sub, a[k] - b[k])
+	BINARY(OP_MUL, op_mul, a[k] * b[k])
+	BINARY(OP_DIV, op_div, b[k] != 0 ? a[k] / b[k] : 0)
+	BINARY(OP_MOD, op_mod, b[k] != 0 ? a[k] - b[k]*floorf(a[k]/b[k]) : 0)
+	BINARY(OP_MIN, op_min, a[k] < b[k] ? a[k] : b[k])
+	BINARY(OP_MAX, op_max, a[k] > b[k] ? a[k] : b[k])
+	BINARY(OP_LT, op_lt, a[k] < b[k] ? 1.0f : 0.0f)
+	UNARY(OP_NEG, op_neg, -a[k])
+	UNARY(OP_ABS, op_abs, fabsf(a[k]))
+	UNARY(OP_FLOOR, op_floor, floorf(a[k]))
+	UNARY(OP_SIN, op_sin, sinf(a[k]))
+	UNARY(OP_COS, op_cos, cosf(a[k]))
+
+	HANDLER(OP_RAND, op_rand) {
+		float* d = vm->stack[sp++];
+		for(k=0; k<n; k++) d[k] = scriptRand(vm);
+		NEXT; }
+
+	HANDLER(OP_DUP, op_dup) {
+		const float* a = vm->stack[sp-1];
+		float* d = vm->stack[sp++];
+		for(k=0; k<n; k++) d[k] = a[k];
+		NEXT; }
+
+	HANDLER(OP_SWAP, op_swap) {
+		float* a = vm->stack[sp-2];
+		float* b = vm->stack[sp-1];
+		for(k=0; k<n; k++) { float t = a[k]; a[k] = b[k]; b[k] = t; }
+		NEXT; }
+
+	// c a b -> c != 0 ? a : b
+	HANDLER(OP_SEL, op_sel) {
+		const float* b = vm->stack[--sp];
+		const float* a = vm->stack[--sp];
+		float* c = vm->stack[sp-1];
+		for(k=0; k<n; k++) c[k] = c[k] != 0 ? a[k] : b[k];
+		NEXT; }
+
+#ifndef SCRIPT_THREADED
+	default:
+		return;
+	}
+#endif
+#undef HANDLER
+#undef NEXT
+#undef BINARY
+#undef UNARY
+}
+
+/* Copies a program and swaps every op number for its handler */
+static void threadCode (ScriptCell* dst, const ScriptCell* src, const void* const* handlers)
+{
+	int i = 0;
+	for(;;)
+	{
+		int op = src[i].op;
+		dst[i].op = op;
+		if(handlers)
+			dst[i].handler = handlers[op];
+		i++;
+		if(op == OP_END)
+			return;
+		if(opinfo[op].arg != ARG_NONE)
+		{
+			dst[i] = src[i];
+			i++;
+		}
+	}
+}
+
+void initScriptVM (ScriptVM* vm)
+{
+	vm->script = NULL;
+	vm->ticks = 0;
+	vm->wave = 0;
+	vm->seed = 1;
+	vm->n = 0;
+	for(int s=0; s<BRICK_POOL_CAPACITY; s++)
+		vm->owner[s] = BRICK_NONE;
+}
+
+void attachBrickScript (ScriptVM* vm, const BrickScript* script, unsigned int seed)
+{
+	initScriptVM(vm);
+	vm->script = script;
+	vm->seed = seed ? seed : 1;
+	const void* const* handlers;
+	execute(vm, NULL, NULL, &handlers);
+	threadCode(vm->spawn, script->spawn, handlers);
+	threadCode(vm->tick, script->tick, handlers);
+}
+
+/* New bricks start at the top with the slowest speed; the spawn program
+ * places them and x0, y0 remember where it put them. They appear there,
+ * without sliding in from the top on the first frame drawn. */
+static void spawnWave (ScriptVM* vm, BrickPool* pool)
+{
+	vm->n = 0;
+	for(int id=0; id<vm->script->count; id++)
+	{
+		BrickHandle h = spawnBrick(pool, BRICK_BLACK, 0, 0, 10, 0.03);
+		if(h == BRICK_NONE)
+			break;
+		int s = h & 0xffff;
+		vm->owner[s] = h;
+		vm->age[s] = 0;
+		vm->id[s] = id;
+		for(int r=0; r<SCRIPT_REGS; r++)
+			vm->reg[r][s] = 0;
+		vm->index[vm->n] = pool->count - 1;
+		vm->slot[vm->n] = s;
+		vm->n++;
+	}
+	execute(vm, pool, vm->spawn, NULL);
+	for(int k=0; k<vm->n; k++)
+	{
+		int i = vm->index[k];
+		vm->x0[vm->slot[k]] = pool->x[i];
+		vm->y0[vm->slot[k]] = pool->y[i];
+		pool->prevx[i] = pool->x[i];
+		pool->prevy[i] = pool->y[i];
+	}
+	vm->wave++;
+}
+
+void runBrickScript (ScriptVM* vm, BrickPool* pool)
+{
+	const BrickScript* script = vm->script;
+	if(!script)
+		return;
+
+	if(vm->ticks % script->every == 0 && (script->waves == 0 || vm->wave < script->waves))
+		spawnWave(vm, pool);
+
+	vm->n = 0;
+	for(int j=0; j<pool->count; j++)
+	{
+		int s = pool->handle[j] & 0xffff;
+		if(vm->owner[s] != pool->handle[j] || pool->basket[j] >= 0)
+			continue;
+		vm->index[vm->n] = j;
+		vm->slot[vm->n] = s;
+		vm->n++;
+	}
+	execute(vm, pool, vm->tick, NULL);
+	for(int k=0; k<vm->n; k++)
+		vm->age[vm->slot[k]]++;
+	vm->ticks++;
+}
@@ -0,0 +1,84 @@
+#ifndef BRICKSCRIPT_H
+#define BRICKSCRIPT_H
+
+#include "brickpool.h"
+
+/* Scripted brick patterns.
+ * A script has two small stack programs: "spawn" runs once per wave over the
+ * bricks of that wave and places them, "tick" runs every tick over all the
+ * scripted bricks still falling and moves them. Every value on the stack is
+ * a vector with one entry per brick, so each instruction dispatched works on
+ * the whole group at once. See scripts/ for examples and README.txt for the
+ * instruction set. */
+
+#define SCRIPT_MAX_CODE 512     // cells per program
+#define SCRIPT_STACK 8
+#define SCRIPT_REGS 4
+
+enum ScriptOp {
+	OP_END, OP_PUSH, OP_LOAD, OP_STORE,
+	OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_MIN, OP_MAX, OP_LT,
+	OP_NEG, OP_ABS, OP_FLOOR, OP_SIN, OP_COS,
+	OP_RAND, OP_DUP, OP_SWAP, OP_SEL,
+	NUM_SCRIPT_OPS
+};
+
+enum ScriptVar {
+	// per brick
+	VAR_X, VAR_Y, VAR_SPEED, VAR_TYPE, VAR_R0, VAR_R1, VAR_R2, VAR_R3,
+	VAR_AGE, VAR_ID, VAR_X0, VAR_Y0,
+	// same for every brick
+	VAR_TICK, VAR_WAVE, VAR_COUNT,
+	NUM_SCRIPT_VARS
+};
+#define VAR_LAST_STORE VAR_R3   // variables after this one are read only
+
+/* An op cell is followed by its operand cell, if it has one. Before running,
+ * op numbers are replaced by the address of their handler (direct threading) */
+union ScriptCell {
+	int op;
+	const void* handler;
+	float value;
+	int var;
+};
+
+struct BrickScript {
+	int count;        // bricks per wave
+	int every;        // ticks from one wave to the next
+	int waves;        // 0 for no end
+	ScriptCell spawn[SCRIPT_MAX_CODE];
+	ScriptCell tick[SCRIPT_MAX_CODE];
+};
+
+struct ScriptVM {
+	const BrickScript* script;  // NULL when no script is attached
+	ScriptCell spawn[SCRIPT_MAX_CODE];   // threaded copies of the programs
+	ScriptCell tick[SCRIPT_MAX_CODE];
+	int ticks, wave;
+	unsigned int seed;
+
+	// per pool slot
+	BrickHandle owner[BRICK_POOL_CAPACITY];   // scripted brick in the slot, BRICK_NONE if none
+	int age[BRICK_POOL_CAPACITY];
+	float id[BRICK_POOL_CAPACITY];
+	float x0[BRICK_POOL_CAPACITY], y0[BRICK_POOL_CAPACITY];
+	float reg[SCRIPT_REGS][BRICK_POOL_CAPACITY];
+
+	// bricks the running program works on
+	int n;
+	int index[BRICK_POOL_CAPACITY];           // dense index in the pool
+	int slot[BRICK_POOL_CAPACITY];
+	float stack[SCRIPT_STACK][BRICK_POOL_CAPACITY];
+};
+
+/* Assembles a script file; prints the problem and returns 0 on errors */
+int loadBrickScript (const char* path, BrickScript* script);
+
+void initScriptVM (ScriptVM* vm);
+void attachBrickScript (ScriptVM* vm, const BrickScript* script, unsigned int seed);
+
+/* Spawns the next wave when it is due and moves the scripted bricks.
+ * Bricks that have landed in a box are left alone. */
+void runBrickScript (ScriptVM* vm, BrickPool* pool);
+
+#endif
@@ -0,0 +1,195 @@
+#include <cmath>
+#include <algorithm>
+#include "brickstack.h"
+
+void initSweepAndPrune (SweepAndPrune* sap)
+{
+	sap->n = 0;
+	for(int s=0; s<BRICK_POOL_CAPACITY; s++)
+		sap->tracked[s] = 0;
+}
+
+/* Drops killed bricks from the sorted order and appends new ones at the end;
+ * the insertion sort moves them to their place afterwards */
+static void refreshOrder (BrickPool* pool, SweepAndPrune* sap)
+{
+	int k = 0;
+	for(int o=0; o<sap->n; o++)
+	{
+		int j = brickIndex(pool, sap->order[o]);
+		if(j < 0)
+		{
+			sap->tracked[sap->order[o] & 0xffff] = 0;
+			continue;
+		}
+		sap->order[k] = sap->order[o];
+		sap->index[k] = j;
+		k++;
+	}
+	for(int j=0; j<pool->count; j++)
+	{
+		int s = pool->handle[j] & 0xffff;
+		if(sap->tracked[s])
+			continue;
+		sap->tracked[s] = 1;
+		sap->order[k] = pool->handle[j];
+		sap->index[k] = j;
+		k++;
+	}
+	sap->n = k;
+}
+
+static void sortOrder (SweepAndPrune* sap)
+{
+	for(int k=1; k<sap->n; k++)
+	{
+		float key = sap->minx[k];
+		BrickHandle h = sap->order[k];
+		int j = sap->index[k];
+		int m = k - 1;
+		while(m >= 0 && sap->minx[m] > key)
+		{
+			sap->minx[m+1] = sap->minx[m];
+			sap->order[m+1] = sap->order[m];
+			sap->index[m+1] = sap->index[m];
+			m--;
+		}
+		sap->minx[m+1] = key;
+		sap->order[m+1] = h;
+		sap->index[m+1] = j;
+	}
+}
+
+static void joinBasket (BrickPool* pool, SweepAndPrune* sap, int j, int b, const BrickBasket* baskets, BrickHandle* joined, int* njoined)
+{
+	pool->basket[j] = b;
+	sap->offset[pool->handle[j] & 0xffff] = pool->x[j] - baskets[b].x;
+	joined[(*njoined)++] = pool->handle[j];
+}
+
+/* Pushes two overlapping bricks apart along the axis of least penetration.
+ * A brick that ends up resting on a landed brick lands in the same box. */
+static void resolvePair (BrickPool* pool, SweepAndPrune* sap, int a, int b, float hw, float hh, const BrickBasket* baskets,
+		BrickHandle* joined, int* njoined)
+{
+	float dx = pool->x[b] - pool->x[a];
+	float dy = pool->y[b] - pool->y[a];
+	float px = 2*hw - fabsf(dx);
+	float py = 2*hh - fabsf(dy);
+	if(px <= 0 || py <= 0)
+		return;
+
+	// the walls of a box leave no room to slide sideways, so landed bricks always stack
+	bool landed = pool->basket[a] >= 0 && pool->basket[a] == pool->basket[b];
+	if(py <= px || landed)
+	{
+		int upper = dy > 0 ? b : a;
+		int lower = dy > 0 ? a : b;
+		pool->y[upper] = pool->y[lower] + 2*hh;
+		int k = pool->basket[lower];
+		if(k >= 0 && pool->basket[upper] < 0 && fabsf(pool->x[upper] - baskets[k].x) <= baskets[k].halfwidth)
+			joinBasket(pool, sap, upper, k, baskets, joined, njoined);
+	}
+	else
+	{
+		float push = dx > 0 ? px : -px;
+		// a landed brick is held by its box, so the falling one takes the whole push
+		if(pool->basket[a] >= 0 && pool->basket[b] < 0)
+			pool->x[b] += push;
+		else if(pool->basket[b] >= 0 && pool->basket[a] < 0)
+			pool->x[a] -= push;
+		else
+		{
+			pool->x[a] -= push/2;
+			pool->x[b] += push/2;
+		}
+	}
+}
+
+static bool lowerPair (const BrickPair& p, const BrickPair& q)
+{
+	return p.y < q.y;
+}
+
+int stepBrickStacks (BrickPool* pool, SweepAndPrune* sap, const BrickBasket* baskets, int nbaskets,
+		float hw, float hh, BrickHandle* joined)
+{
+	int njoined = 0;
+	int npairs = 0;
+	int i, k, m;
+
+	refreshOrder(pool, sap);
+
+	// integrate; landed bricks are carried along by their box
+	for(i=0; i<pool->count; i++)
+	{
+		pool->y[i] -= pool->speed[i];
+		int b = pool->basket[i];
+		if(b >= 0)
+		{
+			pool->x[i] = baskets[b].x + sap->offset[pool->handle[i] & 0xffff];
+			if(pool->y[i] - hh < baskets[b].floor)
+				pool->y[i] = baskets[b].floor + hh;
+		}
+	}
+
+	for(k=0; k<sap->n; k++)
+		sap->minx[k] = pool->x[sap->index[k]] - hw;
+	sortOrder(sap);
+
+	// sweep: only bricks whose x intervals overlap are tested
+	for(k=0; k<sap->n; k++)
+	{
+		int a = sap->index[k];
+		float maxx = pool->x[a] + hw;
+		float y = pool->y[a];
+		for(m=k+1; m<sap->n && sap->minx[m] <= maxx; m++)
+		{
+			int b = sap->index[m];
+			if(fabsf(pool->y[b] - y) >= 2*hh || npairs == BRICK_MAX_PAIRS)
+				continue;
+			sap->pairs[npairs].a = a;
+			sap->pairs[npairs].b = b;
+			sap->pairs[npairs].y = y < pool->y[b] ? y : pool->y[b];
+			npairs++;
+		}
+	}
+
+	// resolve from the bottom up so a pile settles in a single pass
+	std::sort(sap->pairs, sap->pairs + npairs, lowerPair);
+	for(k=0; k<npairs; k++)
+		resolvePair(pool, sap, sap->pairs[k].a, sap->pairs[k].b, hw, hh, baskets, joined, &njoined);
+
+	// box walls and floors, and bricks falling in through the top of a box
+	for(i=0; i<pool->count; i++)
+	{
+		int b = pool->basket[i];
+		if(b < 0)
+		{
+			for(k=0; k<nbaskets; k++)
+			{
+				if(fabsf(pool->x[i] - baskets[k].x) <= baskets[k].halfwidth
+						&& pool->y[i] - hh <= baskets[k].top && pool->y[i] + hh >= baskets[k].floor)
+				{
+					joinBasket(pool, sap, i, k, baskets, joined, &njoined);
+					b = k;
+					break;
+				}
+			}
+			if(b < 0)
+				continue;
+		}
+		float wall = baskets[b].halfwidth - hw;
+		float offset = pool->x[i] - baskets[b].x;
+		if(offset < -wall)
+			offset = -wall;
+		if(offset > wall)
+			offset = wall;
+		pool->x[i] = baskets[b].x + offset;
+		sap->offset[pool->handle[i] & 0xffff] = offset;
+		if(pool->y[i] - hh < baskets[b].floor)
+			pool->y[i] = baskets[b].floor + hh;
+	}
+
+	return njoined;
+}
@@ -0,0 +1,47 @@
+#ifndef BRICKSTACK_H
+#define BRICKSTACK_H
+
+#include "brickpool.h"
+
+/* Physical brick mode: bricks collide with each other and pile up inside
+ * the collecting boxes instead of vanishing.
+ * Broadphase is sort-and-sweep on the x axis. The sorted order is kept from
+ * one tick to the next and repaired with an insertion sort; bricks mostly
+ * fall straight down so it is nearly sorted already and the repair is O(n). */
+
+struct BrickBasket {
+	float x;          // centre of the box
+	float halfwidth;
+	float top;        // bricks below this line (or resting on the pile) are in the box
+	float floor;
+};
+
+#define BRICK_MAX_PAIRS (4*BRICK_POOL_CAPACITY)
+
+struct BrickPair {
+	int a, b;         // dense indices of two overlapping bricks
+	float y;          // height of the lower one
+};
+
+struct SweepAndPrune {
+	int n;
+	BrickHandle order[BRICK_POOL_CAPACITY];   // bricks sorted by min x
+	unsigned char tracked[BRICK_POOL_CAPACITY]; // per pool slot, 1 if in order[]
+	float offset[BRICK_POOL_CAPACITY];          // per pool slot, x offset of a landed brick from its box
+
+	// per tick scratch, in sorted order
+	int index[BRICK_POOL_CAPACITY];
+	float minx[BRICK_POOL_CAPACITY];
+	BrickPair pairs[BRICK_MAX_PAIRS];
+};
+
+void initSweepAndPrune (SweepAndPrune* sap);
+
+/* Moves every brick one tick, resolves brick-vs-brick and brick-vs-box
+ * contacts and returns the number of bricks that landed in a box this tick.
+ * Their handles are written to joined[]. Bricks that miss the boxes keep
+ * falling; removing them is left to the caller. */
+int stepBrickStacks (BrickPool* pool, SweepAndPrune* sap, const BrickBasket* baskets, int nbaskets,
+		float brick_halfwidth, float brick_halfheight, BrickHandle* joined);
+
+#endif
@@ -0,0 +1,87 @@
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "camera.h"
+#include "renderstats.h"
+
+void initCamera (Camera* camera)
+{
+	initCameraView(&camera->view);
+	camera->dirty = true;
+	camera->uploads = 0;
+
+	glGenBuffers(1, &camera->UniformBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, camera->UniformBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), NULL, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, camera->UniformBuffer);
+}
+
+void useCameraBlock (GLuint program)
+{
+	GLuint block = glGetUniformBlockIndex(program, "Camera");
+	if(block != GL_INVALID_INDEX)
+		glUniformBlockBinding(program, block, CAMERA_BINDING);
+}
+
+void initCameraView (CameraView* view)
+{
+	view->xpan = 0;
+	view->ypan = 0;
+	view->zoom = 1;
+}
+
+void panCamera (CameraView* view, float dx, float dy)
+{
+	view->xpan += dx;
+	view->ypan += dy;
+}
+
+void zoomCamera (CameraView* view, float dzoom)
+{
+	view->zoom += dzoom;
+	// at 0 and below the view would be empty or mirrored
+	if(view->zoom < CAMERA_MIN_ZOOM)
+		view->zoom = CAMERA_MIN_ZOOM;
+}
+
+void setCameraView (Camera* camera, const CameraView* view)
+{
+	if(view->xpan == camera->view.xpan && view->ypan == camera->view.ypan && view->zoom == camera->view.zoom)
+		return;
+	camera->view = *view;
+	camera->dirty = true;
+}
+
+void invalidateCamera (Camera* camera)
+{
+	camera->dirty = true;
+}
+
+void viewRect (const CameraView* view, GLfloat rect[4])
+{
+	float z = view->zoom, x = view->xpan, y = view->ypan;
+	rect[0] = -8.0f/z + x;
+	rect[1] = -8.0f/z + y;
+	rect[2] = 8.0f/z + x;
+	rect[3] = 8.0f/z + y;
+}
+
+void updateCamera (Camera* camera)
+{
+	if(!camera->dirty)
+		return;
+	camera->dirty = false;
+
+	GLfloat rect[4];
+	viewRect(&camera->view, rect);
+	glm::mat4 projection = glm::ortho(rect[0], rect[2], rect[1], rect[3], 0.1f, 500.0f);
+	// fixed camera for 2D (ortho) in the XY plane
+	glm::mat4 view = glm::lookAt(glm::vec3(0,0,3), glm::vec3(0,0,0), glm::vec3(0,1,0));
+	glm::mat4 VP = projection * view;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, camera->UniformBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof VP, &VP[0][0]);
+	countUpload(sizeof VP);
+	camera->uploads++;
+}
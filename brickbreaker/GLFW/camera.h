@@ -0,0 +1,49 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <glad/glad.h>
+
+/* The 2D camera.
+ * View-projection lives in a uniform buffer bound to the "Camera" block of
+ * every world space program. It is only rebuilt and uploaded by updateCamera
+ * after a pan or zoom has marked it dirty; objects just pass their offset,
+ * rotation and scale to the shader. */
+
+#define CAMERA_BINDING 0        // uniform buffer binding point of the block
+#define CAMERA_MIN_ZOOM 0.1f    // zoomCamera goes no further out
+
+/* Where the camera looks. The keys move a view on the simulation thread;
+ * the render thread hands it to setCameraView every frame. */
+struct CameraView {
+	float xpan, ypan, zoom;
+};
+
+struct Camera {
+	GLuint UniformBuffer;
+	CameraView view;
+	bool dirty;
+	int uploads;                // times the block has been written
+};
+
+void initCamera (Camera* camera);
+
+/* Connects the program's Camera block, if it has one, to the camera buffer */
+void useCameraBlock (GLuint program);
+
+void initCameraView (CameraView* view);
+void panCamera (CameraView* view, float dx, float dy);
+void zoomCamera (CameraView* view, float dzoom);
+
+/* The part of the world the view shows: min x, min y, max x, max y */
+void viewRect (const CameraView* view, GLfloat rect[4]);
+
+/* Marks the camera dirty if the view differs from the one it has */
+void setCameraView (Camera* camera, const CameraView* view);
+
+/* For when the framebuffer changes under the camera */
+void invalidateCamera (Camera* camera);
+
+/* Uploads view-projection if the camera moved since the last call */
+void updateCamera (Camera* camera);
+
+#endif
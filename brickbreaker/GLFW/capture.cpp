@@ -0,0 +1,255 @@
+#include <cstring>
+#include <vector>
+#include "capture.h"
+#include "trace.h"
+
+static inline unsigned char luma (const unsigned char* p)
+{
+	return (77*p[0] + 150*p[1] + 29*p[2] + 128) >> 8;
+}
+
+/* RGBA, bottom row first, to planar 4:2:0 YUV, top row first: full range
+ * BT.601 as the C420jpeg header says, chroma averaged over 2x2 pixels.
+ * One pass over two rows at a time; an odd last row or column is paired
+ * with itself. */
+static void convertFrame (const unsigned char* rgba, int width, int height, unsigned char* yuv)
+{
+	int cw = (width + 1)/2, ch = (height + 1)/2;
+	unsigned char* U = yuv + width*height;
+	unsigned char* V = U + cw*ch;
+
+	for(int cy=0; cy<ch; cy++)
+	{
+		int y0 = 2*cy, y1 = y0 + 1 < height ? y0 + 1 : y0;
+		const unsigned char* a = rgba + 4*width*(height - 1 - y0);
+		const unsigned char* b = rgba + 4*width*(height - 1 - y1);
+		unsigned char* Y0 = yuv + width*y0;
+		unsigned char* Y1 = yuv + width*y1;
+		unsigned char* u = U + cw*cy;
+		unsigned char* v = V + cw*cy;
+		for(int x=0; x<width; x+=2)
+		{
+			// the second column of the pair, or the first again at an odd end
+			const unsigned char* a1 = x + 1 < width ? a + 4 : a;
+			const unsigned char* b1 = x + 1 < width ? b + 4 : b;
+			Y0[x] = luma(a);
+			Y1[x] = luma(b);
+			if(x + 1 < width)
+			{
+				Y0[x + 1] = luma(a1);
+				Y1[x + 1] = luma(b1);
+			}
+			int r = a[0] + a1[0] + b[0] + b1[0];
+			int g = a[1] + a1[1] + b[1] + b1[1];
+			int bl = a[2] + a1[2] + b[2] + b1[2];
+			// sums of four: the shift divides by 4 as well
+			*u++ = (-43*r - 85*g + 128*bl + 4*(32768 + 127)) >> 10;
+			*v++ = (128*r - 107*g - 21*bl + 4*(32768 + 127)) >> 10;
+			a += 8, b += 8;
+		}
+	}
+}
+
+static bool writeFrame (Capture* capture, const std::vector<unsigned char>& yuv)
+{
+	return fputs("FRAME\n", capture->out) >= 0 && fwrite(&yuv[0], 1, yuv.size(), capture->out) == yuv.size();
+}
+
+static void writeFrames (Capture* capture)
+{
+	nameTraceThread("capture");
+	int size = capture->width*capture->height;
+	std::vector<unsigned char> yuv(size + 2*((capture->width + 1)/2)*((capture->height + 1)/2));
+	for(;;)
+	{
+		unsigned char* rgba;
+		int lead;
+		{
+			std::unique_lock<std::mutex> hold(capture->lock);
+			while(capture->count == 0 && !capture->done)
+				capture->changed.wait(hold);
+			if(capture->count == 0)
+				break;
+			rgba = capture->frames[capture->first];
+			lead = capture->leads[capture->first];
+		}
+
+		if(!capture->failed)
+		{
+			TRACE_SCOPE("writeFrame");
+			// yuv still holds the frame before, shown over the gap
+			bool ok = true;
+			for(int i=0; i<lead && ok; i++)
+				ok = writeFrame(capture, yuv);
+			convertFrame(rgba, capture->width, capture->height, &yuv[0]);
+			if(!ok || !writeFrame(capture, yuv))
+			{
+				fprintf(stderr, "Capture: write failed, recording stopped\n");
+				capture->failed = true;
+			}
+		}
+
+		std::lock_guard<std::mutex> hold(capture->lock);
+		capture->first = (capture->first + 1) % CAPTURE_QUEUE;
+		capture->count--;
+		capture->changed.notify_all();
+	}
+	for(long long int i=0; i<capture->trail && !capture->failed; i++)
+		if(!writeFrame(capture, yuv))
+			capture->failed = true;
+}
+
+bool startCapture (Capture* capture, const char* path, int width, int height)
+{
+	capture->pipe = path[0] == '|';
+	capture->out = capture->pipe ? popen(path + 1, "w") : fopen(path, "wb");
+	if(!capture->out)
+	{
+		fprintf(stderr, "Capture: can't open %s\n", path);
+		return false;
+	}
+	capture->width = width;
+	capture->height = height;
+	capture->failed = false;
+	fprintf(capture->out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, CAPTURE_FPS);
+
+	GLsizeiptr size = 4*width*height;
+	glGenBuffers(CAPTURE_BUFFERS, capture->PackBuffers);
+	for(int i=0; i<CAPTURE_BUFFERS; i++)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->PackBuffers[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		capture->fences[i] = 0;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	capture->next = 0;
+	capture->inflight = 0;
+
+	for(int i=0; i<CAPTURE_QUEUE; i++)
+		capture->frames[i] = new unsigned char[size];
+	capture->first = 0;
+	capture->count = 0;
+	capture->done = false;
+	capture->trail = 0;
+	capture->slots = 0;
+	capture->captured = 0;
+	capture->dropped = 0;
+	capture->waits = 0;
+	capture->writer = std::thread(writeFrames, capture);
+	return true;
+}
+
+/* Moves the oldest read back to the writer. Without wait it gives up, and
+ * returns false, if the GPU has not finished it yet. */
+static bool collectFrame (Capture* capture, bool wait)
+{
+	int slot = (capture->next - capture->inflight + CAPTURE_BUFFERS) % CAPTURE_BUFFERS;
+	GLenum status = glClientWaitSync(capture->fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if(status == GL_TIMEOUT_EXPIRED)
+	{
+		if(!wait)
+			return false;
+		capture->waits++;
+		while(status == GL_TIMEOUT_EXPIRED)
+			status = glClientWaitSync(capture->fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+	}
+	glDeleteSync(capture->fences[slot]);
+	capture->fences[slot] = 0;
+	capture->inflight--;
+
+	unsigned char* frame;
+	{
+		std::unique_lock<std::mutex> hold(capture->lock);
+		if(capture->count == CAPTURE_QUEUE)
+		{
+			capture->waits++;
+			while(capture->count == CAPTURE_QUEUE)
+				capture->changed.wait(hold);
+		}
+		int index = (capture->first + capture->count) % CAPTURE_QUEUE;
+		frame = capture->frames[index];
+		capture->leads[index] = capture->pendinglead[slot];
+	}
+
+	GLsizeiptr size = 4*capture->width*capture->height;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->PackBuffers[slot]);
+	const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if(pixels)
+	{
+		memcpy(frame, pixels, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+
+	std::lock_guard<std::mutex> hold(capture->lock);
+	capture->count++;
+	capture->captured++;
+	capture->changed.notify_all();
+	return true;
+}
+
+/* The video frame time falls in */
+static long long int videoFrame (const Capture* capture, double time)
+{
+	return (long long int)((time - capture->start)*CAPTURE_FPS + 0.5);
+}
+
+void captureFrame (Capture* capture, double time)
+{
+	TRACE_SCOPE("captureFrame");
+	if(capture->slots == 0)
+		capture->start = time;
+	long long int videoframe = videoFrame(capture, time);
+	if(capture->slots > 0 && videoframe < capture->slots)
+	{
+		capture->dropped++;
+		return;
+	}
+	int lead = videoframe - capture->slots;
+	capture->slots = videoframe + 1;
+
+	// every buffer still in flight: the oldest has to land before its
+	// buffer can take this frame
+	if(capture->inflight == CAPTURE_BUFFERS)
+		collectFrame(capture, true);
+
+	int slot = capture->next;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->PackBuffers[slot]);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, capture->width, capture->height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+	capture->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	capture->pendinglead[slot] = lead;
+	capture->next = (slot + 1) % CAPTURE_BUFFERS;
+	capture->inflight++;
+
+	// pass on whatever earlier frames have arrived meanwhile
+	while(capture->inflight > 1 && collectFrame(capture, false))
+		;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void stopCapture (Capture* capture, double time)
+{
+	while(capture->inflight > 0)
+		collectFrame(capture, true);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glDeleteBuffers(CAPTURE_BUFFERS, capture->PackBuffers);
+
+	{
+		std::lock_guard<std::mutex> hold(capture->lock);
+		// the last frame stays up until the end, which is the start of
+		// the video frame time falls in
+		capture->trail = 0;
+		if(capture->slots > 0 && videoFrame(capture, time) > capture->slots)
+			capture->trail = videoFrame(capture, time) - capture->slots;
+		capture->slots += capture->trail;
+		capture->done = true;
+		capture->changed.notify_all();
+	}
+	capture->writer.join();
+	for(int i=0; i<CAPTURE_QUEUE; i++)
+		delete[] capture->frames[i];
+	if(capture->pipe)
+		pclose(capture->out);
+	else
+		fclose(capture->out);
+}
@@ -0,0 +1,70 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <glad/glad.h>
+
+/* Records the frames drawn as a YUV4MPEG2 (.y4m) video.
+ * glReadPixels into a pixel pack buffer only queues the copy; a fence after
+ * it tells when the pixels have landed. The frames go round CAPTURE_BUFFERS
+ * such buffers and are only mapped once their fence has passed, so reading
+ * back does not wait for the GPU unless it is that many frames behind. The
+ * pixels are then handed to a writer thread, which converts them to 4:2:0
+ * YUV and writes them out; the render thread only copies them.
+ * The video always runs at CAPTURE_FPS. Each frame is given the time it was
+ * drawn at and takes the video frame that time falls in: a frame landing in
+ * the same video frame as the one before is dropped, and video frames no
+ * frame landed in repeat the last one, so a fast display, or a pause with
+ * nothing drawn, keeps its real length. */
+
+#define CAPTURE_BUFFERS 3         // frames being read back at once
+#define CAPTURE_QUEUE 8           // frames read back and waiting for the writer
+#define CAPTURE_FPS 60            // frame rate of the video
+
+struct Capture {
+	int width, height;
+	FILE* out;
+	bool pipe;                    // out came from popen
+	bool failed;                  // a write failed, the rest is dropped
+
+	GLuint PackBuffers[CAPTURE_BUFFERS];
+	GLsync fences[CAPTURE_BUFFERS];
+	int pendinglead[CAPTURE_BUFFERS];   // leads of the frames being read back
+	int next;                     // pack buffer the next frame is read into
+	int inflight;                 // reads not collected yet, the oldest first
+
+	// RGBA as read back, bottom row first; the writer owns first .. first+count-1
+	unsigned char* frames[CAPTURE_QUEUE];
+	int leads[CAPTURE_QUEUE];     // repeats of the frame before to write ahead of each
+	int first, count;
+	bool done;
+	long long int trail;          // repeats of the last frame to end the video with
+	std::mutex lock;
+	std::condition_variable changed;
+	std::thread writer;
+
+	double start;                 // time of the first frame
+	long long int slots;          // video frames taken so far, repeats included
+	int captured;                 // frames handed to the writer
+	int dropped;                  // frames that shared a video frame with the one before
+	int waits;                    // times the render thread had to wait for the GPU or the writer
+};
+
+/* Starts recording width x height frames into path; "|command" pipes the
+ * video into a command instead, e.g. "|ffmpeg -i - game.mp4". Needs the GL
+ * context current; false if path can't be opened. */
+bool startCapture (Capture* capture, const char* path, int width, int height);
+
+/* Queues the read back of the frame just drawn, before the swap. time is
+ * when it was drawn, in seconds on any clock; a headless run passes its
+ * tick count times GAME_TICK so every frame is one video frame. */
+void captureFrame (Capture* capture, double time);
+
+/* Waits for the frames still on their way, writes them, holds the last one
+ * until time and closes the file */
+void stopCapture (Capture* capture, double time);
+
+#endif
@@ -0,0 +1,24 @@
+#!/bin/sh
+# Prints a C++ header that holds the given files as raw string literals,
+# so the game carries its shaders inside the binary.
+# usage: sh embed.sh FILE... > embedded_assets.h
+# Exits non-zero on any failure, so make never takes half a header.
+
+set -e
+echo "// Generated by embed.sh from the files listed in the Makefile; do not edit"
+echo ""
+echo "static constexpr EmbeddedAsset embeddedassets[] = {"
+for f in "$@"; do
+	if [ ! -r "$f" ]; then
+		echo "embed.sh: can't read $f" >&2
+		exit 1
+	fi
+	if grep -q ')asset"' "$f"; then
+		echo "embed.sh: $f contains the closing delimiter )asset\"" >&2
+		exit 1
+	fi
+	printf '\t{"%s", R"asset(' "$f"
+	cat "$f"
+	printf ')asset"},\n'
+done
+echo "};"
@@ -0,0 +1,358 @@
+#include <cmath>
+#include "game.h"
+
+void initGame (GameState* g, unsigned int seed)
+{
+	g->speedlower = 0.03;
+	g->speedupper = 0.06;
+	g->nlanes = 3;
+	g->lane_min[0] = -5.0, g->lane_max[0] = -1;
+	g->lane_min[1] = -0.99, g->lane_max[1] = 3.00;
+	g->lane_min[2] = 3.01, g->lane_max[2] = 7.00;
+	g->collectingbox_xlength = 0.5;
+	g->collectingbox_ylength = 0.75;
+	g->firecooldown = 0.7;
+	g->nspawners = 9;
+	g->activespawners = 9;
+	g->stackmode = 0;
+
+	g->time = 0;
+	g->seed = seed ? seed : 1;
+	g->gameflag = 0;
+	g->points = 0;
+	g->redbox_x = -2.5;
+	g->greenbox_x = 2.5;
+	g->laser1_x = -7.4;
+	g->laser1_y = 0;
+	g->laser2_rotation = 0;
+	g->laserflag = 0;
+	g->laserx = -7.4, g->lasery = 0;
+	g->laserrotation = 0;
+	g->lastfire = 0;
+	g->prevlaser1_y = g->laser1_y;
+	g->prevlaser2_rotation = g->laser2_rotation;
+	g->prevlaserx = g->laserx, g->prevlasery = g->lasery;
+	g->prevlaserrotation = g->laserrotation;
+
+	initBrickPool(&g->bricks);
+	initSweepAndPrune(&g->sweep);
+	initScriptVM(&g->vm);
+	for(int i=0; i<MAX_SPAWNERS; i++)
+		g->spawners[i] = BRICK_NONE;
+}
+
+/* Splits the playing field x in [-5, 7] into n equal lanes, with one
+ * spawner per brick type in every lane */
+void setLanes (GameState* g, int nlanes)
+{
+	if(nlanes < 1)
+		nlanes = 1;
+	if(nlanes > MAX_LANES)
+		nlanes = MAX_LANES;
+	g->nlanes = nlanes;
+	for(int j=0; j<nlanes; j++)
+	{
+		g->lane_min[j] = -5.0 + 12.0*j/nlanes;
+		g->lane_max[j] = -5.0 + 12.0*(j+1)/nlanes;
+	}
+	g->nspawners = 3*nlanes;
+	g->activespawners = g->nspawners;
+}
+
+/* xorshift, so every game has its own random sequence */
+int gameRand (GameState* g)
+{
+	unsigned int x = g->seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	g->seed = x;
+	return (int)(x >> 1);
+}
+
+void restartGame (GameState* g)
+{
+	g->gameflag = 0;
+	g->points = 0;
+	releaseBasketBricks(g);
+}
+
+void increasespeed (GameState* g)
+{
+	int i;
+	for(i=0;i<g->bricks.count;i++)
+	{
+		if(g->bricks.speed[i] <3.5 )
+		{
+			g->bricks.speed[i]+=0.03;
+		}
+	}
+	if(g->speedupper < 3.5)
+	{
+		g->speedupper += 0.03;
+		g->speedlower += 0.03;
+	}
+}
+void decreasespeed (GameState* g)
+{
+	int i;
+	for(i=0;i<g->bricks.count;i++)
+	{
+		if(g->bricks.speed[i] > 0.001 )
+		{
+			g->bricks.speed[i]-=0.02;
+		}
+	}
+	if(g->speedlower > 0.02 )
+	{
+		g->speedlower-=0.02;
+		g->speedupper -= 0.02;
+	}
+}
+void moveRedBoxleft (GameState* g)
+{
+	if(g->redbox_x > -7.2)
+		g->redbox_x -= 0.15;
+}
+void moveRedBoxright (GameState* g)
+{
+	if(g->redbox_x < 7.2)
+		g->redbox_x += 0.15;
+}
+void moveGreenBoxleft (GameState* g)
+{
+	if(g->greenbox_x > -7.2)
+		g->greenbox_x -= 0.15;
+}
+void moveGreenBoxright (GameState* g)
+{
+	if(g->greenbox_x < 7.2)
+		g->greenbox_x += 0.15;
+}
+void movecannonup (GameState* g)
+{
+	if(g->laser1_y < 7.0)
+		g->laser1_y += 0.2;
+}
+void movecannondown (GameState* g)
+{
+	if(g->laser1_y > -5.3)
+		g->laser1_y -= 0.2;
+}
+void rotatecannonright (GameState* g)
+{
+	if(g->laser2_rotation > -70.0)
+		g->laser2_rotation -= 3;
+}
+void rotatecannonleft (GameState* g)
+{
+	if(g->laser2_rotation < 70.0)
+		g->laser2_rotation += 3;
+}
+
+/* Shoots from the cannon, at most once every firecooldown seconds */
+void fireLaser (GameState* g)
+{
+	if((g->time - g->lastfire) >= g->firecooldown)
+	{
+		g->lastfire = g->time;
+		g->laserflag=1;
+		g->laserrotation = g->laser2_rotation;
+		g->lasery= g->laser1_y;
+		g->laserx= g->laser1_x;
+		// a new shot starts where it is, not where the last one ended
+		g->prevlaserx = g->laserx, g->prevlasery = g->lasery;
+		g->prevlaserrotation = g->laserrotation;
+	}
+}
+
+/* Refill every spawner whose brick has been shot, collected or has fallen off */
+static void spawnBricks (GameState* g)
+{
+	int i;
+	for(i=0;i<g->activespawners;i++)
+	{
+		if(brickIndex(&g->bricks, g->spawners[i]) >= 0)
+			continue;
+		int lane = (i/3)%g->nlanes;
+		float brickspeed = 0.01 +static_cast <float> (gameRand(g)) /( static_cast <float> (GAME_RAND_MAX/g->speedupper - g->speedlower));
+		float brickx = g->lane_min[lane]+ static_cast <float> (gameRand(g)) /( static_cast <float> (GAME_RAND_MAX/(g->lane_max[lane]-g->lane_min[lane])));
+		g->spawners[i] = spawnBrick(&g->bricks, i%3, lane, brickx, 10, brickspeed);
+		int j = brickIndex(&g->bricks, g->spawners[i]);
+		if(j >= 0)
+			g->bricks.spawner[j] = i;
+	}
+}
+
+/* Removes every brick that has landed in a box (stacking mode) */
+void releaseBasketBricks (GameState* g)
+{
+	int i;
+	for(i=0;i<g->bricks.count;)
+	{
+		if(g->bricks.basket[i] >= 0)
+			killBrick(&g->bricks, i);
+		else
+			i++;
+	}
+}
+
+static void moveLaser (GameState* g)
+{
+	int i;
+	if(g->lasery+fabs(sin(g->laserrotation*M_PI/180)) <( mirror1y + 1* sin(mirror1rotation*M_PI/180.0f)) && ( g->lasery+fabs(sin(g->laserrotation*M_PI/180)) > mirror1y -1*sin(mirror1rotation*M_PI/180.0f)))
+	{
+		if(fabs(mirror1x - g->laserx)<= laser_xlength + ( 0.5*cos(g->laserrotation*M_PI/180)))
+		{
+			g->laserrotation = 2*mirror1rotation -g->laserrotation;
+			// a bounce turns the shot at once, not over the tick
+			g->prevlaserrotation = g->laserrotation;
+		}
+	}
+	if((fabs(mirror2x - g->laserx)<= laser_xlength +0.05) && (fabs(mirror2y - g->lasery)<= laser_xlength+ 1 ))
+	{
+		g->laserrotation = 2*mirror2rotation -g->laserrotation;
+		g->prevlaserrotation = g->laserrotation;
+	}
+
+	if(g->laserflag!=1)
+		return;
+
+	if(g->laserx>=8 || g->laserx<=-8 || g->lasery >=8 || g->lasery<= -6)
+	{
+		g->laserflag=0;
+		g->laserx = -7;
+	}
+
+	BrickPool* bricks = &g->bricks;
+	for(i=0;i<bricks->count; i++)
+	{
+		if(g->lasery <= bricks->y[i]+brick_ylength && g->lasery >= bricks->y[i] - brick_ylength)
+		{
+			if(fabs(bricks->x[i]-g->laserx) <=( laser_xlength*cos(g->laserrotation*M_PI/180)+ brick_xlength) || fabs(g->laserx - bricks->x[i]) <=( fabs(laser_xlength*cos(g->laserrotation*M_PI/180))+ brick_xlength))
+			{
+				g->laserflag=0;
+				g->laserx = -7;
+				if(bricks->type[i] != BRICK_BLACK)
+					g->points -= 2; //decreasing points on hitting green or red brick
+				else
+					g->points += 3;  //increasing points on hitting black brick
+				killBrick(bricks, i);
+				break;
+			}
+		}
+	}
+
+	g->laserx+= 0.5 *cos(g->laserrotation*M_PI/180); //speed * cos to get distance in x direction
+	g->lasery+= 0.5 *sin(g->laserrotation*M_PI/180);
+	if(g->laserx>=8 || g->laserx<=-8 || g->lasery >=8 || g->lasery<= -6)
+	{
+		g->laserflag=0;
+		g->laserx = -7;
+	}
+}
+
+/* Bricks reaching a box are collected and vanish */
+static void fallBricks (GameState* g)
+{
+	BrickPool* bricks = &g->bricks;
+	int i;
+	for(i=0;i<bricks->count ;)
+	{
+		int collected = 0;
+		if(bricks->x[i] > (g->redbox_x- g->collectingbox_xlength)  && bricks->x[i] < (g->redbox_x + g->collectingbox_xlength) )
+		{
+			if(fabs(-7 - bricks->y[i] ) < (g->collectingbox_ylength + brick_ylength))
+			{
+				if(bricks->type[i]==BRICK_RED)
+					g->points += 2;
+				collected = 1;
+				if(bricks->type[i]==BRICK_BLACK)
+					g->gameflag=1; //terminate the game i.e gameover
+			}
+		}
+		else if(bricks->x[i] > (g->greenbox_x- g->collectingbox_xlength)  && bricks->x[i] < (g->greenbox_x + g->collectingbox_xlength) )
+		{
+			if(fabs(-7 - bricks->y[i]) < (g->collectingbox_ylength + brick_ylength))
+			{
+				if(bricks->type[i]==BRICK_GREEN)
+					g->points += 2;
+				collected = 1;
+				if(bricks->type[i]==BRICK_BLACK)
+					g->gameflag=1; //terminate the game i.e gameover
+			}
+		}
+		if(collected || bricks->y[i] <= -7)
+		{
+			// swap-remove: the brick moved into slot i is visited next
+			killBrick(bricks, i);
+			continue;
+		}
+		bricks->y[i] -=bricks->speed[i];
+		i++;
+	}
+}
+
+/* Stacking mode: bricks land in the boxes and pile up instead of vanishing.
+ * Scoring is the same as in the normal mode, applied when a brick lands. */
+static void stackBricks (GameState* g)
+{
+	BrickPool* bricks = &g->bricks;
+	BrickBasket baskets[2];
+	baskets[0].x = g->redbox_x;
+	baskets[1].x = g->greenbox_x;
+	for(int k=0;k<2;k++)
+	{
+		baskets[k].halfwidth = g->collectingbox_xlength;
+		baskets[k].top = -7 + g->collectingbox_ylength;
+		baskets[k].floor = -7 - g->collectingbox_ylength;
+	}
+
+	int n = stepBrickStacks(bricks, &g->sweep, baskets, 2, brick_xlength, brick_ylength, g->joined);
+	for(int k=0;k<n;k++)
+	{
+		int i = brickIndex(bricks, g->joined[k]);
+		if(bricks->type[i]==BRICK_BLACK)
+			g->gameflag=1;
+		else if(bricks->type[i]==BRICK_RED && bricks->basket[i]==0)
+			g->points += 2;
+		else if(bricks->type[i]==BRICK_GREEN && bricks->basket[i]==1)
+			g->points += 2;
+		// the spawner lets go of a landed brick and drops a new one
+		if(bricks->spawner[i] >= 0)
+			g->spawners[bricks->spawner[i]] = BRICK_NONE;
+		bricks->spawner[i] = -1;
+	}
+
+	// bricks that missed the boxes, and piles that grew off the top of the screen
+	for(int i=0;i<bricks->count;)
+	{
+		if((bricks->basket[i] < 0 && bricks->y[i] <= -7) || (bricks->basket[i] >= 0 && bricks->y[i] > 8))
+			killBrick(bricks, i);
+		else
+			i++;
+	}
+}
+
+/* Advances the game by one tick of GAME_TICK seconds */
+void stepGame (GameState* g)
+{
+	if(g->gameflag)
+		return;
+
+	g->time += GAME_TICK;
+	g->prevlaser1_y = g->laser1_y;
+	g->prevlaser2_rotation = g->laser2_rotation;
+	g->prevlaserx = g->laserx, g->prevlasery = g->lasery;
+	g->prevlaserrotation = g->laserrotation;
+	saveBrickPositions(&g->bricks);
+	moveLaser(g);
+	if(g->vm.script)
+		runBrickScript(&g->vm, &g->bricks);
+	else
+		spawnBricks(g);
+	if(g->stackmode)
+		stackBricks(g);
+	else
+		fallBricks(g);
+}
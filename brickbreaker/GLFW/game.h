@@ -0,0 +1,88 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "brickpool.h"
+#include "brickstack.h"
+#include "brickscript.h"
+
+/* Game simulation without any rendering.
+ * Everything one game needs lives in a GameState, so several games can be
+ * simulated side by side (see sweep.cpp); the window game keeps one of them. */
+
+#define GAME_TICK (1.0/60)     // simulated seconds per stepGame()
+#define MAX_SPAWNERS BRICK_POOL_CAPACITY
+#define MAX_LANES 8
+#define GAME_RAND_MAX 0x7fffffff
+
+const float brick_xlength = 0.2;
+const float brick_ylength = 0.3;
+const float laser_xlength = 0.1;
+const float laser_ylength = 0.05;
+const float laser1_xlength = 0.5;
+const float laser1_ylength = 0.6;
+const float laser2_xlength = 1;
+const float laser2_ylength = 0.2;
+
+/* mirrors are fixed, the laser bounces off them */
+const float mirror1x = 6.0, mirror1y = 0.0, mirror1rotation = 90;
+const float mirror2x = -4.0, mirror2y = -4.5, mirror2rotation = 120;
+
+struct GameState {
+	/* tunables, set before the first stepGame() */
+	float speedlower, speedupper;  // range of brick falling speeds, per tick
+	int nlanes;
+	float lane_min[MAX_LANES], lane_max[MAX_LANES];
+	float collectingbox_xlength;   // half size in x of the collecting boxes
+	float collectingbox_ylength;   // half size in y of the collecting boxes
+	double firecooldown;           // seconds between two shots
+	int nspawners;                 // spawner i keeps one brick of type i%3 falling in lane (i/3)%nlanes
+	int activespawners;            // spawners actually refilled, lowered by the load governor
+	int stackmode;                 // bricks pile up in the boxes instead of vanishing
+
+	/* state */
+	double time;                   // simulated seconds
+	unsigned int seed;
+	int gameflag;                  // 1 once a black brick reached a box
+	long long int points;
+
+	float redbox_x, greenbox_x;
+	float laser1_x, laser1_y;      // cannon, shared by both of its parts
+	float laser2_rotation;         // barrel angle in degrees
+	float laserflag;               // 1 while a shot is flying
+	float laserx, lasery, laserrotation;
+	double lastfire;
+
+	/* the cannon and the shot before the last tick; drawn part of the way
+	 * from there, frames come more often than ticks (bricks keep theirs
+	 * in the pool) */
+	float prevlaser1_y, prevlaser2_rotation;
+	float prevlaserx, prevlasery, prevlaserrotation;
+
+	BrickPool bricks;
+	BrickHandle spawners[MAX_SPAWNERS];
+	SweepAndPrune sweep;
+	BrickHandle joined[BRICK_POOL_CAPACITY];
+	ScriptVM vm;                   // with a script attached it drops the bricks instead of the spawners
+};
+
+void initGame (GameState* g, unsigned int seed);
+void setLanes (GameState* g, int nlanes);
+void stepGame (GameState* g);
+void restartGame (GameState* g);
+int gameRand (GameState* g);
+
+/* player actions */
+void increasespeed (GameState* g);
+void decreasespeed (GameState* g);
+void moveRedBoxleft (GameState* g);
+void moveRedBoxright (GameState* g);
+void moveGreenBoxleft (GameState* g);
+void moveGreenBoxright (GameState* g);
+void movecannonup (GameState* g);
+void movecannondown (GameState* g);
+void rotatecannonright (GameState* g);
+void rotatecannonleft (GameState* g);
+void fireLaser (GameState* g);
+void releaseBasketBricks (GameState* g);
+
+#endif
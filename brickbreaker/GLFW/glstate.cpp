@@ -0,0 +1,138 @@
+#include <cstring>
+#include "glstate.h"
+#include "renderstats.h"
+
+GLStateCache glstate;
+
+// no GL name or enum is ~0, so these never match a real request
+#define UNKNOWN_NAME (~0u)
+
+void resetGLState ()
+{
+	glstate.program = UNKNOWN_NAME;
+	glstate.vao = UNKNOWN_NAME;
+	glstate.arraybuffer = UNKNOWN_NAME;
+	glstate.texture = UNKNOWN_NAME;
+	glstate.polygonmode = UNKNOWN_NAME;
+	glstate.blend = -1;
+	glstate.depthtest = -1;
+	for(int i=0; i<GLSTATE_CONST_ATTRIBS; i++)
+		glstate.constknown[i] = false;
+	// the enabled attributes belong to the vertex arrays and stay valid
+}
+
+/* Counts a request; returns true when it would change nothing */
+static bool redundant (bool same)
+{
+	glstate.calls++;
+	if(same)
+		glstate.skipped++;
+	else
+		countStat(STAT_STATE_CHANGES);
+	return same;
+}
+
+void useProgram (GLuint program)
+{
+	if(redundant(glstate.program == program))
+		return;
+	glstate.program = program;
+	glUseProgram(program);
+}
+
+void bindVertexArray (GLuint vao)
+{
+	if(redundant(glstate.vao == vao))
+		return;
+	glstate.vao = vao;
+	countStat(STAT_VAO_BINDS);
+	glBindVertexArray(vao);
+}
+
+void bindArrayBuffer (GLuint buffer)
+{
+	if(redundant(glstate.arraybuffer == buffer))
+		return;
+	glstate.arraybuffer = buffer;
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+}
+
+void bindTexture2D (GLuint texture)
+{
+	if(redundant(glstate.texture == texture))
+		return;
+	glstate.texture = texture;
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void polygonMode (GLenum mode)
+{
+	if(redundant(glstate.polygonmode == mode))
+		return;
+	glstate.polygonmode = mode;
+	glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void setCapability (GLenum cap, bool on)
+{
+	int* known = cap == GL_BLEND ? &glstate.blend : &glstate.depthtest;
+	if(redundant(*known == (int)on))
+		return;
+	*known = on;
+	if(on)
+		glEnable(cap);
+	else
+		glDisable(cap);
+}
+
+bool capabilityEnabled (GLenum cap)
+{
+	int* known = cap == GL_BLEND ? &glstate.blend : &glstate.depthtest;
+	if(*known < 0)
+		*known = glIsEnabled(cap);
+	return *known;
+}
+
+void enableVertexAttrib (GLuint index)
+{
+	GLuint vao = glstate.vao;
+	if(vao < GLSTATE_MAX_VAOS)
+	{
+		if(redundant(glstate.attribs[vao] & (1u << index)))
+			return;
+		glstate.attribs[vao] |= 1u << index;
+	}
+	else
+	{
+		glstate.calls++;
+		countStat(STAT_STATE_CHANGES);
+	}
+	glEnableVertexAttribArray(index);
+}
+
+void vertexAttrib3fv (GLuint index, const GLfloat* v)
+{
+	if(index < GLSTATE_CONST_ATTRIBS)
+	{
+		bool same = glstate.constknown[index] && memcmp(glstate.constattrib[index], v, 3*sizeof(GLfloat)) == 0;
+		if(redundant(same))
+			return;
+		memcpy(glstate.constattrib[index], v, 3*sizeof(GLfloat));
+		glstate.constknown[index] = true;
+	}
+	else
+	{
+		glstate.calls++;
+		countStat(STAT_STATE_CHANGES);
+	}
+	glVertexAttrib3fv(index, v);
+}
+
+void endGLStateFrame ()
+{
+	glstate.framecalls = glstate.calls;
+	glstate.frameskipped = glstate.skipped;
+	glstate.totalskipped += glstate.skipped;
+	glstate.calls = 0;
+	glstate.skipped = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <glad/glad.h>
+
+/* Redundant GL state filter.
+ * Remembers the program, vertex array, array buffer, 2D texture, polygon mode,
+ * blend and depth test switches, the enabled attributes of every vertex
+ * array and the constant values of the first few attributes, and only
+ * passes a call on to GL when it changes something. Everything that binds
+ * or switches this state has to go through here, or the cache has to be
+ * told with resetGLState. Textures are only tracked on unit 0. */
+
+#define GLSTATE_MAX_VAOS 256       // vertex arrays with higher names are not tracked
+#define GLSTATE_CONST_ATTRIBS 4
+
+struct GLStateCache {
+	GLuint program;
+	GLuint vao;
+	GLuint arraybuffer;
+	GLuint texture;
+	GLenum polygonmode;
+	int blend, depthtest;          // -1 while unknown
+	unsigned int attribs[GLSTATE_MAX_VAOS];   // enabled attributes, a bit each
+	GLfloat constattrib[GLSTATE_CONST_ATTRIBS][3];
+	bool constknown[GLSTATE_CONST_ATTRIBS];
+
+	long long int calls, skipped;             // this frame
+	long long int framecalls, frameskipped;   // the last whole frame
+	long long int totalskipped;
+};
+
+extern GLStateCache glstate;
+
+/* Forgets the bindings and switches, for after code that went around the cache */
+void resetGLState ();
+
+void useProgram (GLuint program);
+void bindVertexArray (GLuint vao);
+void bindArrayBuffer (GLuint buffer);
+void bindTexture2D (GLuint texture);
+void polygonMode (GLenum mode);                    // for GL_FRONT_AND_BACK
+void setCapability (GLenum cap, bool on);          // GL_BLEND or GL_DEPTH_TEST
+bool capabilityEnabled (GLenum cap);
+
+/* Works on the vertex array bound through bindVertexArray */
+void enableVertexAttrib (GLuint index);
+
+/* glVertexAttrib3fv, the value an attribute without an array has */
+void vertexAttrib3fv (GLuint index, const GLfloat* v);
+
+/* Closes the frame's call counts; call once per frame */
+void endGLStateFrame ();
+
+#endif
@@ -0,0 +1,51 @@
+#include "governor.h"
+
+#define GOVERNOR_SMOOTHING 0.1    // weight of the newest frame in the average
+#define GOVERNOR_SETTLE 30        // frames to let a change take effect
+#define GOVERNOR_HEADROOM 0.5     // restore only when under half the budget ...
+#define GOVERNOR_CALM_FRAMES 120  // ... for this many frames in a row
+
+void initGovernor (LoadGovernor* gov, double budget, int maxlevel)
+{
+	gov->budget = budget;
+	gov->cost = 0;
+	gov->level = 0;
+	gov->maxlevel = maxlevel;
+	gov->cooldown = 0;
+	gov->calm = 0;
+}
+
+int updateGovernor (LoadGovernor* gov, double simtime, double rendertime)
+{
+	if(gov->budget <= 0)
+		return 0;
+
+	gov->cost += GOVERNOR_SMOOTHING * (simtime + rendertime - gov->cost);
+	if(gov->cooldown > 0)
+	{
+		gov->cooldown--;
+		return 0;
+	}
+
+	if(gov->cost > gov->budget && gov->level < gov->maxlevel)
+	{
+		gov->level++;
+		gov->cooldown = GOVERNOR_SETTLE;
+		gov->calm = 0;
+		return 1;
+	}
+
+	if(gov->cost < GOVERNOR_HEADROOM * gov->budget)
+		gov->calm++;
+	else
+		gov->calm = 0;
+
+	if(gov->calm >= GOVERNOR_CALM_FRAMES && gov->level > 0)
+	{
+		gov->level--;
+		gov->cooldown = GOVERNOR_SETTLE;
+		gov->calm = 0;
+		return -1;
+	}
+	return 0;
+}
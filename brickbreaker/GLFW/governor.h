@@ -0,0 +1,23 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+/* Keeps simulation + render time per frame inside a budget.
+ * When the smoothed frame cost goes over the budget the governor steps the
+ * load level up (less work); once there is plenty of headroom for a while it
+ * steps back down. The caller decides what a level means. */
+
+struct LoadGovernor {
+	double budget;     // seconds per frame, 0 disables the governor
+	double cost;       // smoothed sim + render time
+	int level;         // 0 = full load
+	int maxlevel;
+	int cooldown;      // frames to wait after a change before the next one
+	int calm;          // consecutive frames with headroom
+};
+
+void initGovernor (LoadGovernor* gov, double budget, int maxlevel);
+
+/* Feeds one frame's timings; returns +1 to shed load, -1 to restore it, 0 otherwise */
+int updateGovernor (LoadGovernor* gov, double simtime, double rendertime);
+
+#endif
@@ -0,0 +1,141 @@
+#include <cstdio>
+#include <vector>
+#include "headless.h"
+
+#if !defined(__APPLE__) && !defined(NO_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+static GLuint framebuffer, renderbuffers[2];
+static int fbwidth, fbheight;
+
+/* Mesa's surfaceless platform needs neither X nor a GPU; any other EGL
+ * gets its default display */
+static EGLDisplay openDisplay ()
+{
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if(getPlatformDisplay)
+	{
+		EGLDisplay d = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		if(d != EGL_NO_DISPLAY)
+			return d;
+	}
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static EGLContext createContext ()
+{
+	static const EGLint attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	// nothing is drawn to an EGL surface, so no config is needed where
+	// EGL_KHR_no_config_context allows it
+	EGLContext c = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs);
+	if(c != EGL_NO_CONTEXT)
+		return c;
+
+	static const EGLint want[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config;
+	EGLint n = 0;
+	if(!eglChooseConfig(display, want, &config, 1, &n) || n == 0)
+		return EGL_NO_CONTEXT;
+	return eglCreateContext(display, config, EGL_NO_CONTEXT, attribs);
+}
+
+bool initHeadless (int width, int height)
+{
+	EGLint major, minor;
+	display = openDisplay();
+	if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		fprintf(stderr, "Headless: no EGL display\n");
+		return false;
+	}
+	eglBindAPI(EGL_OPENGL_API);
+	context = createContext();
+	if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		fprintf(stderr, "Headless: no GL 3.3 core context (EGL error 0x%x)\n", eglGetError());
+		return false;
+	}
+	gladLoadGLLoader((GLADloadproc) eglGetProcAddress);
+
+	// colour and depth, like the window's default framebuffer
+	fbwidth = width;
+	fbheight = height;
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(2, renderbuffers);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		fprintf(stderr, "Headless: framebuffer incomplete\n");
+		return false;
+	}
+	return true;
+}
+
+void makeHeadlessCurrent (bool current)
+{
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, current ? context : EGL_NO_CONTEXT);
+}
+
+void finishHeadlessFrame ()
+{
+	glFlush();
+}
+
+bool saveHeadlessFrame (const char* path)
+{
+	FILE* file = fopen(path, "wb");
+	if(!file)
+		return false;
+	std::vector<unsigned char> pixels(3*fbwidth*fbheight);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, fbwidth, fbheight, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+
+	// GL's rows start at the bottom, PPM's at the top
+	fprintf(file, "P6\n%d %d\n255\n", fbwidth, fbheight);
+	for(int y=fbheight-1; y>=0; y--)
+		fwrite(&pixels[3*fbwidth*y], 1, 3*fbwidth, file);
+	return fclose(file) == 0;
+}
+
+void closeHeadless ()
+{
+	if(display == EGL_NO_DISPLAY)
+		return;
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if(context != EGL_NO_CONTEXT)
+		eglDestroyContext(display, context);
+	eglTerminate(display);
+	display = EGL_NO_DISPLAY;
+	context = EGL_NO_CONTEXT;
+}
+
+#else
+
+bool initHeadless (int width, int height)
+{
+	fprintf(stderr, "Headless: needs EGL, which this build does not have\n");
+	return false;
+}
+
+void makeHeadlessCurrent (bool current) {}
+void finishHeadlessFrame () {}
+bool saveHeadlessFrame (const char* path) { return false; }
+void closeHeadless () {}
+
+#endif
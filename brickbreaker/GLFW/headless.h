@@ -0,0 +1,29 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <glad/glad.h>
+
+/* Rendering without a display, for thumbnails, replays and benchmarks on
+ * machines with neither a screen nor a GPU (Mesa llvmpipe does the work).
+ * Instead of a GLFW window the game gets a GL 3.3 core context from EGL on
+ * Mesa's surfaceless platform, and draws into a framebuffer object of the
+ * window's size, which stays bound as the draw target. GLFW is not started
+ * at all. Linux only, and only when built with libEGL (not "make EGL=0");
+ * otherwise initHeadless just fails. */
+
+/* Creates the context, makes it current and loads GL; false if there is
+ * no EGL to be had */
+bool initHeadless (int width, int height);
+
+/* Moves the context to the calling thread, or releases it */
+void makeHeadlessCurrent (bool current);
+
+/* In place of a buffer swap: sends the frame on its way */
+void finishHeadlessFrame ();
+
+/* Writes the framebuffer as a binary PPM; false if the file can't be written */
+bool saveHeadlessFrame (const char* path);
+
+void closeHeadless ();
+
+#endif
@@ -0,0 +1,76 @@
+#include <cstring>
+#include "histogram.h"
+
+#define SUBBUCKETS (1 << HISTOGRAM_SUBBITS)
+
+void initTimeHistogram (TimeHistogram* h, const char* name)
+{
+	h->name = name;
+	memset(h->counts, 0, sizeof h->counts);
+	h->n = 0;
+	h->sum = 0;
+	h->max = 0;
+}
+
+/* Microseconds below SUBBUCKETS have a bucket each; above, the top
+ * HISTOGRAM_SUBBITS+1 bits pick the bucket within the power of two */
+static int bucketOf (unsigned long long us)
+{
+	if(us >= 1ull << HISTOGRAM_MAXBITS)
+		us = (1ull << HISTOGRAM_MAXBITS) - 1;
+	if(us < SUBBUCKETS)
+		return us;
+	int msb = 63 - __builtin_clzll(us);
+	int shift = msb - HISTOGRAM_SUBBITS;
+	return ((shift + 1) << HISTOGRAM_SUBBITS) + (int)(us >> shift) - SUBBUCKETS;
+}
+
+/* The highest microsecond count that falls in bucket */
+static unsigned long long bucketTop (int bucket)
+{
+	if(bucket < SUBBUCKETS)
+		return bucket;
+	int shift = (bucket >> HISTOGRAM_SUBBITS) - 1;
+	unsigned long long low = (unsigned long long)(SUBBUCKETS + (bucket & (SUBBUCKETS - 1))) << shift;
+	return low + (1ull << shift) - 1;
+}
+
+void recordTime (TimeHistogram* h, double seconds)
+{
+	if(seconds < 0)
+		seconds = 0;
+	h->counts[bucketOf((unsigned long long)(seconds*1e6))]++;
+	h->n++;
+	h->sum += seconds;
+	if(seconds > h->max)
+		h->max = seconds;
+}
+
+double timePercentile (const TimeHistogram* h, double percent)
+{
+	if(h->n == 0)
+		return 0;
+	// the rank of the sample wanted, counting from 1
+	long long int rank = (long long int)(percent/100*h->n + 0.999999);
+	if(rank < 1)
+		rank = 1;
+	long long int seen = 0;
+	for(int b=0; b<HISTOGRAM_BUCKETS; b++)
+	{
+		seen += h->counts[b];
+		if(seen >= rank)
+		{
+			double top = (bucketTop(b) + 1)*1e-6;
+			return top < h->max ? top : h->max;
+		}
+	}
+	return h->max;
+}
+
+void printTimeHistogram (const TimeHistogram* h, FILE* out)
+{
+	fprintf(out, "%-8s %7lld frames  mean %7.3f  p50 %7.3f  p90 %7.3f  p99 %7.3f  p99.9 %7.3f  max %7.3f ms\n",
+		h->name, h->n, h->n ? h->sum/h->n*1000 : 0,
+		timePercentile(h, 50)*1000, timePercentile(h, 90)*1000, timePercentile(h, 99)*1000,
+		timePercentile(h, 99.9)*1000, h->max*1000);
+}
@@ -0,0 +1,35 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <cstdio>
+
+/* Distribution of a time, kept HDR histogram style so that rare long frames
+ * show up next to the common ones. Times are counted in whole microseconds;
+ * up to 2^HISTOGRAM_SUBBITS they each have a bucket, above that every power
+ * of two is split into 2^HISTOGRAM_SUBBITS buckets, so a bucket is never
+ * wider than 1/128 of the values in it. Recording is a few shifts and an
+ * increment; percentiles are read off the counts. Times over 2^24 us (16 s)
+ * fall in the last bucket, but the maximum is kept exact. */
+
+#define HISTOGRAM_SUBBITS 7
+#define HISTOGRAM_MAXBITS 24
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAXBITS - HISTOGRAM_SUBBITS + 1) << HISTOGRAM_SUBBITS)
+
+struct TimeHistogram {
+	const char* name;
+	long long int counts[HISTOGRAM_BUCKETS];
+	long long int n;
+	double sum, max;              // seconds
+};
+
+void initTimeHistogram (TimeHistogram* h, const char* name);
+void recordTime (TimeHistogram* h, double seconds);
+
+/* The time percentile percent of the recorded ones are at or under, to
+ * within a bucket; 0 if nothing was recorded */
+double timePercentile (const TimeHistogram* h, double percent);
+
+/* One line: count, mean, p50, p90, p99, p99.9 and the worst, in ms */
+void printTimeHistogram (const TimeHistogram* h, FILE* out);
+
+#endif
@@ -0,0 +1,150 @@
+#include <chrono>
+#include "profiler.h"
+
+#define PROFILER_SMOOTHING 0.1    // weight of the newest frame in the average
+
+static double now ()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void initProfiler (Profiler* profiler, const char* const* names, int nscopes)
+{
+	if(nscopes > PROFILER_SCOPES)
+		nscopes = PROFILER_SCOPES;
+	profiler->nscopes = nscopes;
+	for(int i=0; i<nscopes; i++)
+	{
+		profiler->scopes[i].name = names[i];
+		profiler->scopes[i].cpu = 0;
+		profiler->scopes[i].gpu = 0;
+		profiler->scopes[i].framecpu = 0;
+	}
+	for(int f=0; f<PROFILER_LATENCY; f++)
+	{
+		glGenQueries(PROFILER_ENTRIES, profiler->sets[f].queries);
+		profiler->sets[f].n = 0;
+		profiler->sets[f].pending = false;
+	}
+	profiler->frame = 0;
+	profiler->open = -1;
+	profiler->query = false;
+	profiler->late = 0;
+}
+
+/* Folds the GPU times of a set issued PROFILER_LATENCY frames ago into the
+ * averages, if they have arrived */
+static void readSet (Profiler* profiler, ProfileSet* set)
+{
+	if(!set->pending)
+		return;
+	set->pending = false;
+
+	// queries finish in order, so the last one stands for all
+	GLint available = 0;
+	glGetQueryObjectiv(set->queries[set->n - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if(!available)
+	{
+		profiler->late++;
+		return;
+	}
+
+	double gpu[PROFILER_SCOPES] = {0};
+	for(int i=0; i<set->n; i++)
+	{
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(set->queries[i], GL_QUERY_RESULT, &ns);
+		gpu[set->scopes[i]] += ns*1e-6;
+	}
+	for(int s=0; s<profiler->nscopes; s++)
+		profiler->scopes[s].gpu += PROFILER_SMOOTHING*(gpu[s] - profiler->scopes[s].gpu);
+}
+
+void beginProfileFrame (Profiler* profiler)
+{
+	ProfileSet* set = &profiler->sets[profiler->frame % PROFILER_LATENCY];
+	readSet(profiler, set);
+	set->n = 0;
+	for(int s=0; s<profiler->nscopes; s++)
+		profiler->scopes[s].framecpu = 0;
+}
+
+void beginScope (Profiler* profiler, int scope)
+{
+	if(scope == profiler->open)
+		return;
+	endScope(profiler);
+
+	ProfileSet* set = &profiler->sets[profiler->frame % PROFILER_LATENCY];
+	profiler->query = set->n < PROFILER_ENTRIES;
+	if(profiler->query)
+	{
+		set->scopes[set->n] = scope;
+		glBeginQuery(GL_TIME_ELAPSED, set->queries[set->n]);
+		set->n++;
+	}
+	profiler->open = scope;
+	profiler->openstart = now();
+}
+
+void endScope (Profiler* profiler)
+{
+	if(profiler->open < 0)
+		return;
+	if(profiler->query)
+		glEndQuery(GL_TIME_ELAPSED);
+	profiler->scopes[profiler->open].framecpu += now() - profiler->openstart;
+	profiler->open = -1;
+	profiler->query = false;
+}
+
+void endProfileFrame (Profiler* profiler)
+{
+	endScope(profiler);
+	ProfileSet* set = &profiler->sets[profiler->frame % PROFILER_LATENCY];
+	set->pending = set->n > 0;
+	for(int s=0; s<profiler->nscopes; s++)
+	{
+		ProfileScope* scope = &profiler->scopes[s];
+		scope->cpu += PROFILER_SMOOTHING*(scope->framecpu*1000 - scope->cpu);
+	}
+	profiler->frame++;
+}
+
+void initFrameTimer (FrameTimer* timer)
+{
+	for(int f=0; f<PROFILER_LATENCY; f++)
+	{
+		glGenQueries(2, timer->queries[f]);
+		timer->pending[f] = false;
+	}
+	timer->frame = 0;
+	timer->gpu = 0;
+}
+
+void beginFrameTimer (FrameTimer* timer)
+{
+	int f = timer->frame % PROFILER_LATENCY;
+	if(timer->pending[f])
+	{
+		// a set still on its way is given up, its queries are needed now
+		GLint available = 0;
+		glGetQueryObjectiv(timer->queries[f][1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if(available)
+		{
+			GLuint64 start = 0, end = 0;
+			glGetQueryObjectui64v(timer->queries[f][0], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(timer->queries[f][1], GL_QUERY_RESULT, &end);
+			timer->gpu = (end - start)*1e-9;
+		}
+	}
+	glQueryCounter(timer->queries[f][0], GL_TIMESTAMP);
+}
+
+void endFrameTimer (FrameTimer* timer)
+{
+	int f = timer->frame % PROFILER_LATENCY;
+	glQueryCounter(timer->queries[f][1], GL_TIMESTAMP);
+	timer->pending[f] = true;
+	timer->frame++;
+}
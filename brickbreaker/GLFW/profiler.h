@@ -0,0 +1,69 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+/* CPU and GPU time of the parts of a frame.
+ * The code drawing a frame opens named scopes one after the other; each
+ * scope entry takes the CPU time until the next one opens and wraps its GL
+ * commands in a GL_TIME_ELAPSED query. Queries are read PROFILER_LATENCY
+ * frames later and only if the GPU has finished them; a late set is skipped
+ * rather than waited for. The times are smoothed the same way as the frame
+ * time. Scopes do not nest, since elapsed time queries can't. */
+
+#define PROFILER_SCOPES 16        // named scopes
+#define PROFILER_ENTRIES 32       // scope entries in one frame
+#define PROFILER_LATENCY 3        // frames of queries in flight
+
+struct ProfileScope {
+	const char* name;
+	double cpu, gpu;              // smoothed ms per frame
+	double framecpu;              // seconds so far in this frame
+};
+
+struct ProfileSet {
+	int n;
+	int scopes[PROFILER_ENTRIES];
+	GLuint queries[PROFILER_ENTRIES];
+	bool pending;                 // issued and not read back yet
+};
+
+struct Profiler {
+	int nscopes;
+	ProfileScope scopes[PROFILER_SCOPES];
+	ProfileSet sets[PROFILER_LATENCY];
+	int frame;
+	int open;                     // scope open now, -1 between scopes
+	bool query;                   // the open entry has a query running
+	double openstart;
+	int late;                     // query sets skipped because the GPU was behind
+};
+
+/* GPU time of whole frames, always on, for the load governor. A
+ * GL_TIMESTAMP is taken at the start and at the end of each frame and read
+ * PROFILER_LATENCY frames later, only if it has arrived, as the scopes are.
+ * Timestamps, unlike elapsed time queries, can be taken while a scope is
+ * open. */
+struct FrameTimer {
+	GLuint queries[PROFILER_LATENCY][2];
+	bool pending[PROFILER_LATENCY];
+	int frame;
+	double gpu;                   // seconds, of the latest frame read back
+};
+
+/* names[i] becomes scope i */
+void initProfiler (Profiler* profiler, const char* const* names, int nscopes);
+
+void beginProfileFrame (Profiler* profiler);
+
+/* Closes the open scope, if another, and opens this one */
+void beginScope (Profiler* profiler, int scope);
+void endScope (Profiler* profiler);
+
+void endProfileFrame (Profiler* profiler);
+
+void initFrameTimer (FrameTimer* timer);
+void beginFrameTimer (FrameTimer* timer);
+void endFrameTimer (FrameTimer* timer);
+
+#endif
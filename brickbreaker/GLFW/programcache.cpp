@@ -0,0 +1,165 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "programcache.h"
+
+#define CACHE_MAGIC 0x42524b50u     // "BRKP"
+
+struct CacheHeader {
+	unsigned int magic;
+	unsigned int format;        // binary format the driver gave
+	ProgramKey key;             // checked again, in case of a hash file name clash
+	unsigned int length;
+};
+
+/* $BRICKBREAKER_SHADER_CACHE, else brickbreaker in the user's cache
+ * directory, else .shadercache where the game was started */
+static const char* cacheDir ()
+{
+	static std::string dir;
+	const char* env = getenv("BRICKBREAKER_SHADER_CACHE");
+	if(env)
+		return env;
+	if(dir.empty())
+	{
+		const char* xdg = getenv("XDG_CACHE_HOME");
+		const char* home = getenv("HOME");
+		if(xdg && xdg[0] == '/')
+			dir = std::string(xdg) + "/brickbreaker";
+		else if(home && home[0] != '\0')
+			dir = std::string(home) + "/.cache/brickbreaker";
+		else
+			dir = ".shadercache";
+	}
+	return dir.c_str();
+}
+
+/* Creates the cache directory and any missing parents; says once why not
+ * if that fails, after which programs are simply not saved */
+static bool makeCacheDir ()
+{
+	static bool reported = false;
+	std::string dir = cacheDir();
+	for(size_t i = 1; i <= dir.size(); i++)
+	{
+		if(i < dir.size() && dir[i] != '/')
+			continue;
+		std::string part = dir.substr(0, i);
+		if(mkdir(part.c_str(), 0755) != 0 && errno != EEXIST)
+		{
+			if(!reported)
+				fprintf(stderr, "Shader cache: can't create %s (%s)\n", part.c_str(), strerror(errno));
+			reported = true;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool programCacheEnabled ()
+{
+	if(!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary)
+		return false;
+	if(cacheDir()[0] == '\0')
+		return false;
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+static ProgramKey fnv1a (ProgramKey h, const char* s)
+{
+	// the terminating zero is hashed too, so "ab"+"c" differs from "a"+"bc"
+	do {
+		h ^= (unsigned char)*s;
+		h *= 1099511628211ull;
+	} while(*s++);
+	return h;
+}
+
+ProgramKey programKey (const char* vertexsource, const char* fragmentsource)
+{
+	ProgramKey h = 14695981039346656037ull;
+	h = fnv1a(h, vertexsource);
+	h = fnv1a(h, fragmentsource);
+	h = fnv1a(h, (const char*)glGetString(GL_VENDOR));
+	h = fnv1a(h, (const char*)glGetString(GL_RENDERER));
+	h = fnv1a(h, (const char*)glGetString(GL_VERSION));
+	return h;
+}
+
+static std::string cachePath (ProgramKey key)
+{
+	char name[32];
+	snprintf(name, sizeof name, "/%016llx.bin", key);
+	return std::string(cacheDir()) + name;
+}
+
+GLuint loadProgramBinary (ProgramKey key)
+{
+	FILE* f = fopen(cachePath(key).c_str(), "rb");
+	if(!f)
+		return 0;
+	CacheHeader header;
+	std::vector<char> binary;
+	bool ok = fread(&header, sizeof header, 1, f) == 1
+		&& header.magic == CACHE_MAGIC && header.key == key && header.length > 0;
+	if(ok)
+	{
+		binary.resize(header.length);
+		ok = fread(&binary[0], 1, header.length, f) == header.length;
+	}
+	fclose(f);
+	if(!ok)
+		return 0;
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.format, &binary[0], header.length);
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if(!linked)
+	{
+		// the driver changed under an unchanged version string, or the file is bad
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void saveProgramBinary (ProgramKey key, GLuint program)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0)
+		return;
+	std::vector<char> binary(length);
+	CacheHeader header;
+	GLenum format;
+	glGetProgramBinary(program, length, NULL, &format, &binary[0]);
+	header.magic = CACHE_MAGIC;
+	header.format = format;
+	header.key = key;
+	header.length = length;
+
+	// written under a private name and renamed, so that instances starting
+	// at the same time never read a half written file
+	if(!makeCacheDir())
+		return;
+	std::string path = cachePath(key);
+	char tmp[64];
+	snprintf(tmp, sizeof tmp, ".%d.tmp", (int)getpid());
+	std::string tmppath = path + tmp;
+	FILE* f = fopen(tmppath.c_str(), "wb");
+	if(!f)
+		return;
+	bool ok = fwrite(&header, sizeof header, 1, f) == 1
+		&& fwrite(&binary[0], 1, length, f) == (size_t)length;
+	ok = fclose(f) == 0 && ok;
+	if(!ok || rename(tmppath.c_str(), path.c_str()) != 0)
+		remove(tmppath.c_str());
+}
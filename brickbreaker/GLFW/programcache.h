@@ -0,0 +1,28 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <glad/glad.h>
+
+/* On-disk cache of linked program binaries.
+ * A program is stored under a 64 bit FNV-1a hash of its shader sources and
+ * the GL vendor, renderer and version strings, so editing a shader or
+ * changing the driver simply misses the cache. Anything that goes wrong on
+ * the way in (no binary support, a missing, short or stale file, a driver
+ * refusing the binary) makes the caller compile from source as before.
+ * The directory is $BRICKBREAKER_SHADER_CACHE if set, where an empty string
+ * turns the cache off; otherwise $XDG_CACHE_HOME/brickbreaker or
+ * ~/.cache/brickbreaker, and .shadercache only when neither is known. */
+
+typedef unsigned long long int ProgramKey;
+
+bool programCacheEnabled ();
+
+ProgramKey programKey (const char* vertexsource, const char* fragmentsource);
+
+/* A linked program for key, or 0 if the cache does not have a usable one */
+GLuint loadProgramBinary (ProgramKey key);
+
+/* Stores a program linked with PROGRAM_BINARY_RETRIEVABLE_HINT set */
+void saveProgramBinary (ProgramKey key, GLuint program);
+
+#endif
@@ -0,0 +1,61 @@
+#include "renderqueue.h"
+#include "trace.h"
+
+void initRenderQueue (RenderQueue* queue)
+{
+	for(int i=0; i<RENDER_FRAMES; i++)
+	{
+		queue->frames[i].nobjects = 0;
+		queue->frames[i].nbricks = 0;
+		queue->frames[i].rendertime = 0;
+	}
+	queue->first = 0;
+	queue->count = 0;
+	queue->closed = false;
+}
+
+/* The slots in use run from first, in the order they were recorded: the one
+ * being drawn, then any waiting for it. The one after them is recorded into. */
+RenderFrame* recordFrame (RenderQueue* queue)
+{
+	TRACE_SCOPE("recordFrame");
+	std::unique_lock<std::mutex> hold(queue->lock);
+	while(queue->count == RENDER_FRAMES && !queue->closed)
+		queue->changed.wait(hold);
+	if(queue->closed)
+		return NULL;
+	return &queue->frames[(queue->first + queue->count) % RENDER_FRAMES];
+}
+
+void submitFrame (RenderQueue* queue)
+{
+	std::lock_guard<std::mutex> hold(queue->lock);
+	queue->count++;
+	queue->changed.notify_all();
+}
+
+RenderFrame* nextFrame (RenderQueue* queue)
+{
+	TRACE_SCOPE("nextFrame");
+	std::unique_lock<std::mutex> hold(queue->lock);
+	while(queue->count == 0 && !queue->closed)
+		queue->changed.wait(hold);
+	if(queue->count == 0)
+		return NULL;
+	return &queue->frames[queue->first];
+}
+
+void releaseFrame (RenderQueue* queue)
+{
+	std::lock_guard<std::mutex> hold(queue->lock);
+	queue->first = (queue->first + 1) % RENDER_FRAMES;
+	queue->count--;
+	queue->changed.notify_all();
+}
+
+void closeRenderQueue (RenderQueue* queue)
+{
+	std::lock_guard<std::mutex> hold(queue->lock);
+	queue->closed = true;
+	queue->changed.notify_all();
+}
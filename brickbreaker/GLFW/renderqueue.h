@@ -0,0 +1,84 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <mutex>
+#include <condition_variable>
+#include <glad/glad.h>
+#include "brickpool.h"
+#include "camera.h"
+
+/* Hands frames from the simulation to the render thread.
+ * The simulation thread polls events, moves the game and writes down what
+ * the frame shows as a RenderFrame: a plain list of object and brick
+ * records, nothing in it touches GL. The render thread owns the context and
+ * draws the frames in the order they were recorded. There are RENDER_FRAMES
+ * slots, so frame N+1 is simulated while frame N is drawn and swapped; when
+ * every slot is taken the simulation waits, it never runs further ahead. */
+
+#define RENDER_FRAMES 2           // slots; the simulation is at most one frame ahead
+#define RENDER_MAX_OBJECTS 32     // boxes, cannon, laser, mirrors ... per frame
+#define RENDER_STATUS 512         // simulation lines of the debug HUD
+
+struct VAO;
+
+struct RenderObject {
+	VAO* object;
+	GLfloat x, y, rotation;       // rotation in degrees
+	GLfloat prevx, prevy, prevrotation;   // the same a tick earlier
+	int layer;
+	int scope;                    // what the profiler counts it under
+};
+
+struct RenderFrame {
+	bool running;                 // false once the game is over and no input asks
+	                              // for a redraw: nothing is drawn
+	float alpha;                  // how far the frame is from the previous tick to the last, 0-1
+	int width, height;            // framebuffer
+	CameraView view;
+	bool batching, debughud, profiling;
+	float renderscale;            // of the world's resolution, set by the load governor
+	long long points;
+
+	int nobjects;
+	RenderObject objects[RENDER_MAX_OBJECTS];
+	int nbricks;
+	GLfloat bricks[3*BRICK_POOL_CAPACITY];   // x, y, type of every live brick
+	GLfloat prevbricks[2*BRICK_POOL_CAPACITY];   // x, y of each a tick earlier
+	int brickorder;               // the bricks are drawn before this object
+	char status[RENDER_STATUS];
+	double simtime;               // spent moving the game on for this frame
+	bool reporttimes;             // print the frame time histograms once it is drawn
+
+	// written by the render thread; the simulation reads it when the slot
+	// comes back to it, a frame or two later. CPU and GPU work overlap, so
+	// it is the longer of the two: the CPU time to draw the frame, or the
+	// GPU time of a frame read back a few frames earlier.
+	double rendertime;
+};
+
+struct RenderQueue {
+	RenderFrame frames[RENDER_FRAMES];
+	int first;                    // oldest frame not yet drawn
+	int count;                    // frames recorded and not yet released
+	bool closed;
+	std::mutex lock;
+	std::condition_variable changed;
+};
+
+void initRenderQueue (RenderQueue* queue);
+
+/* Simulation side: waits for a free slot and returns it to be filled in,
+ * then submitFrame passes it on. NULL once the queue is closed. */
+RenderFrame* recordFrame (RenderQueue* queue);
+void submitFrame (RenderQueue* queue);
+
+/* Render side: waits for the oldest recorded frame, which stays untouched
+ * until releaseFrame. NULL once the queue is closed and every frame
+ * recorded before has been drawn. */
+RenderFrame* nextFrame (RenderQueue* queue);
+void releaseFrame (RenderQueue* queue);
+
+/* Wakes both sides; nothing more can be recorded */
+void closeRenderQueue (RenderQueue* queue);
+
+#endif
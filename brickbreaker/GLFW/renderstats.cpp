@@ -0,0 +1,63 @@
+#include "renderstats.h"
+
+RenderStats renderstats;
+
+static const char* const statnames[NSTATS] = {
+	"draws", "vertices", "uniforms", "uploads", "upload_bytes", "state_changes", "vao_binds", "culled"
+};
+
+void reportRenderStats (int every, FILE* json)
+{
+	renderstats.every = every;
+	renderstats.json = json;
+}
+
+long long int renderStat (RenderStat stat)
+{
+	return renderstats.last[stat];
+}
+
+const char* renderStatName (RenderStat stat)
+{
+	return statnames[stat];
+}
+
+static void report ()
+{
+	double n = renderstats.frames;
+	FILE* out = renderstats.json;
+	if(out)
+	{
+		fprintf(out, "{\"frame\":%lld,\"frames\":%d", renderstats.frame, renderstats.frames);
+		for(int s=0; s<NSTATS; s++)
+			fprintf(out, ",\"%s\":%.1f", statnames[s], renderstats.interval[s]/n);
+		fprintf(out, "}\n");
+		fflush(out);
+	}
+	else
+	{
+		printf("Frame %lld, per frame:", renderstats.frame);
+		for(int s=0; s<NSTATS; s++)
+			printf(" %s %.1f", statnames[s], renderstats.interval[s]/n);
+		printf("\n");
+	}
+}
+
+void endRenderStatsFrame ()
+{
+	for(int s=0; s<NSTATS; s++)
+	{
+		renderstats.last[s] = renderstats.counts[s];
+		renderstats.interval[s] += renderstats.counts[s];
+		renderstats.counts[s] = 0;
+	}
+	renderstats.frame++;
+	renderstats.frames++;
+	if(renderstats.every > 0 && renderstats.frames == renderstats.every)
+	{
+		report();
+		for(int s=0; s<NSTATS; s++)
+			renderstats.interval[s] = 0;
+		renderstats.frames = 0;
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <cstdio>
+
+/* Counts of the work handed to GL each frame: draw calls, vertices drawn
+ * (instances times vertices each), glUniform* calls, buffer uploads and the
+ * bytes in them, state changes that got past the state cache, vertex array
+ * binds and objects or instances left out for being outside the view.
+ * The code issuing the calls counts them; endRenderStatsFrame closes a
+ * frame, and renderStat then gives its counts. Every so many frames the
+ * averages per frame can be reported, as text on stdout or as one JSON
+ * object per line in a file. Only the thread drawing counts or reads. */
+
+enum RenderStat {
+	STAT_DRAWS, STAT_VERTICES, STAT_UNIFORMS, STAT_UPLOADS, STAT_UPLOAD_BYTES,
+	STAT_STATE_CHANGES, STAT_VAO_BINDS, STAT_CULLED, NSTATS
+};
+
+struct RenderStats {
+	long long int counts[NSTATS];      // this frame
+	long long int last[NSTATS];        // the last whole frame
+	long long int interval[NSTATS];    // summed since the last report
+	int frames;                        // frames in interval
+	long long int frame;               // frames closed so far
+	int every;                         // frames between reports, 0 = none
+	FILE* json;                        // reports go here if set, else to stdout
+};
+
+extern RenderStats renderstats;
+
+static inline void countStat (RenderStat stat, long long int n = 1)
+{
+	renderstats.counts[stat] += n;
+}
+
+/* One draw call of vertices vertices, instances times over */
+static inline void countDraw (long long int vertices, long long int instances = 1)
+{
+	renderstats.counts[STAT_DRAWS]++;
+	renderstats.counts[STAT_VERTICES] += vertices*instances;
+}
+
+/* One upload of bytes bytes into a buffer */
+static inline void countUpload (long long int bytes)
+{
+	renderstats.counts[STAT_UPLOADS]++;
+	renderstats.counts[STAT_UPLOAD_BYTES] += bytes;
+}
+
+/* Reports every so many frames, to json if it is open, else to stdout */
+void reportRenderStats (int every, FILE* json);
+
+/* The count of the last whole frame */
+long long int renderStat (RenderStat stat);
+const char* renderStatName (RenderStat stat);
+
+/* Closes the frame's counts, and reports when it is time; call once per frame */
+void endRenderStatsFrame ();
+
+#endif
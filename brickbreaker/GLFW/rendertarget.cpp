@@ -0,0 +1,57 @@
+#include "rendertarget.h"
+
+void initRenderTarget (RenderTarget* target)
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target->screen);
+	glGenFramebuffers(1, &target->Framebuffer);
+	glGenRenderbuffers(2, target->Renderbuffers);
+	target->width = 0;
+	target->height = 0;
+	target->scaled = false;
+}
+
+static void allocateStorage (RenderTarget* target, int width, int height)
+{
+	glBindRenderbuffer(GL_RENDERBUFFER, target->Renderbuffers[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, target->Renderbuffers[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, target->Framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target->Renderbuffers[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target->Renderbuffers[1]);
+	target->width = width;
+	target->height = height;
+}
+
+void beginRenderTarget (RenderTarget* target, int width, int height, float scale)
+{
+	target->drawwidth = width;
+	target->drawheight = height;
+	int w = (int)(width*scale + 0.5f), h = (int)(height*scale + 0.5f);
+	target->scaled = scale < 1 && w > 0 && h > 0;
+	if(!target->scaled)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, target->screen);
+		glViewport(0, 0, width, height);
+		return;
+	}
+	// the storage only changes with the scale or the window size
+	if(w != target->width || h != target->height)
+		allocateStorage(target, w, h);
+	glBindFramebuffer(GL_FRAMEBUFFER, target->Framebuffer);
+	glViewport(0, 0, w, h);
+}
+
+void resolveRenderTarget (RenderTarget* target)
+{
+	if(!target->scaled)
+		return;
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, target->Framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target->screen);
+	glBlitFramebuffer(0, 0, target->width, target->height,
+		0, 0, target->drawwidth, target->drawheight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, target->screen);
+	glViewport(0, 0, target->drawwidth, target->drawheight);
+}
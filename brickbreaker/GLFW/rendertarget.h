@@ -0,0 +1,33 @@
+#ifndef RENDERTARGET_H
+#define RENDERTARGET_H
+
+#include <glad/glad.h>
+
+/* Drawing the world at less than the window's resolution, a lever for the
+ * load governor: fill and fragment work shrink with the square of the
+ * scale. Under scale 1 the world is drawn into a framebuffer object of the
+ * scaled size and then stretched over the window by a linear blit; what is
+ * drawn after that, the HUD, goes to the window at full resolution and
+ * stays sharp. At scale 1 everything is drawn straight to the window. The
+ * framebuffer bound when the target is made is taken to be the window's. */
+
+struct RenderTarget {
+	GLuint Framebuffer;
+	GLuint Renderbuffers[2];      // colour, depth
+	GLint screen;                 // the window's framebuffer
+	int width, height;            // of the storage, 0 before there is any
+	int drawwidth, drawheight;    // of the frame being drawn
+	bool scaled;                  // this frame goes through the target
+};
+
+void initRenderTarget (RenderTarget* target);
+
+/* Binds where a width x height frame drawn at scale goes, and sets the
+ * viewport to match */
+void beginRenderTarget (RenderTarget* target, int width, int height, float scale);
+
+/* Stretches a scaled frame over the window; the window is left bound with
+ * a viewport over all of it */
+void resolveRenderTarget (RenderTarget* target);
+
+#endif
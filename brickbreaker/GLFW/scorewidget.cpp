@@ -0,0 +1,95 @@
+#include <cstddef>
+#include "scorewidget.h"
+#include "glstate.h"
+#include "camera.h"
+#include "shadermanager.h"
+#include "renderstats.h"
+
+#define SCORE_PITCH 1.0f          // from one digit to the next
+#define SEGMENT_G (1u << 6)
+
+/* Lit segments of 0-9; the 9 has no bottom segment */
+static const GLuint digitsegments[10] = {
+	0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x67
+};
+
+void initScoreWidget (ScoreWidget* score, GLuint program, float x, float y, int mindigits)
+{
+	score->program = program;
+	score->linked = false;
+	score->x = x;
+	score->y = y;
+	score->mindigits = mindigits < 1 ? 1 : mindigits;
+	score->color[0] = score->color[1] = score->color[2] = 0;
+	score->value = 0;
+	score->decoded = false;
+	score->ndigits = 0;
+
+	glGenVertexArrays(1, &score->VertexArrayID);
+	glGenBuffers(1, &score->InstanceBuffer);
+	bindVertexArray(score->VertexArrayID);
+	bindArrayBuffer(score->InstanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof score->digits, NULL, GL_DYNAMIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ScoreDigit), (void*)0);
+	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(ScoreDigit), (void*)(2*sizeof(GLfloat)));
+	glVertexAttribDivisor(0, 1);
+	glVertexAttribDivisor(1, 1);
+	enableVertexAttrib(0);
+	enableVertexAttrib(1);
+	bindVertexArray(0);
+}
+
+void setScore (ScoreWidget* score, long long int value)
+{
+	if(score->decoded && value == score->value)
+		return;
+	score->value = value;
+	score->decoded = true;
+
+	// unsigned so that the most negative value has a magnitude too
+	unsigned long long int left = value < 0 ? 0ull - (unsigned long long int)value : value;
+	int n = 0;
+	float x = score->x;
+	while(n < score->mindigits || left)
+	{
+		score->digits[n].x = x;
+		score->digits[n].y = score->y;
+		score->digits[n].segments = digitsegments[left % 10];
+		left /= 10;
+		x -= SCORE_PITCH;
+		n++;
+	}
+	if(value < 0)
+	{
+		score->digits[n].x = x;
+		score->digits[n].y = score->y;
+		score->digits[n].segments = SEGMENT_G;
+		n++;
+	}
+	score->ndigits = n;
+
+	bindArrayBuffer(score->InstanceBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, n*sizeof(ScoreDigit), score->digits);
+	countUpload(n*sizeof(ScoreDigit));
+}
+
+void drawScore (ScoreWidget* score)
+{
+	if(score->ndigits == 0)
+		return;
+	if(!score->linked)
+	{
+		finishProgram(score->program);
+		useCameraBlock(score->program);
+		score->ColorID = glGetUniformLocation(score->program, "Color");
+		score->linked = true;
+	}
+	useProgram(score->program);
+	glUniform3fv(score->ColorID, 1, score->color);
+	countStat(STAT_UNIFORMS);
+	polygonMode(GL_FILL);
+	bindVertexArray(score->VertexArrayID);
+	// six vertices for each of the seven segments
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 7*6, score->ndigits);
+	countDraw(7*6, score->ndigits);
+}
@@ -0,0 +1,44 @@
+#ifndef SCOREWIDGET_H
+#define SCOREWIDGET_H
+
+#include <glad/glad.h>
+
+/* Seven segment score display.
+ * Each digit is one instance carrying its place and a bitmask of the lit
+ * segments (bit 0 is the top segment a, going round to f, bit 6 is the
+ * middle segment g). The vertex shader builds all seven segments of every
+ * instance and folds away the ones whose bit is clear, so the whole score
+ * is a single instanced draw. Digits are only decoded when the value changes. */
+
+#define SCORE_MAX_DIGITS 20   // enough for any long long, plus the minus sign
+
+struct ScoreDigit {
+	GLfloat x, y;             // lower left corner of the digit
+	GLuint segments;
+};
+
+struct ScoreWidget {
+	GLuint program;
+	bool linked;              // set up on the first draw, see shadermanager.h
+	GLint ColorID;
+	GLuint VertexArrayID;
+	GLuint InstanceBuffer;
+
+	float x, y;               // lower left corner of the last digit
+	int mindigits;            // leading zeros are shown up to this many digits
+	GLfloat color[3];
+
+	long long int value;
+	bool decoded;             // digits below match value
+	int ndigits;
+	ScoreDigit digits[SCORE_MAX_DIGITS];
+};
+
+void initScoreWidget (ScoreWidget* score, GLuint program, float x, float y, int mindigits);
+
+/* Decodes and uploads the digits, but only when value differs from the shown one */
+void setScore (ScoreWidget* score, long long int value);
+
+void drawScore (ScoreWidget* score);
+
+#endif
@@ -0,0 +1,116 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "shadermanager.h"
+#include "programcache.h"
+#include "assets.h"
+#include "trace.h"
+
+struct PendingProgram {
+	GLuint program;
+	GLuint vertex, fragment;     // 0 for a program from the cache
+	std::string vertexname, fragmentname;
+	ProgramKey key;
+	bool cache;
+};
+
+static std::vector<PendingProgram> pending;
+static bool parallel;
+
+void initShaderManager ()
+{
+	parallel = GLAD_GL_ARB_parallel_shader_compile;
+	if(parallel)
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);   // as many as the driver likes
+}
+
+static GLuint submitShader (GLenum type, const char* name, const std::string& source)
+{
+	printf("Compiling shader : %s\n", name);
+	GLuint shader = glCreateShader(type);
+	const char* pointer = source.c_str();
+	glShaderSource(shader, 1, &pointer, NULL);
+	glCompileShader(shader);
+	return shader;
+}
+
+GLuint submitProgram (const char* vertexasset, const char* fragmentasset)
+{
+	TRACE_SCOPE("submitProgram");
+	std::string vertexsource, fragmentsource;
+	if(!loadAsset(vertexasset, &vertexsource))
+		fprintf(stderr, "No shader %s\n", vertexasset);
+	if(!loadAsset(fragmentasset, &fragmentsource))
+		fprintf(stderr, "No shader %s\n", fragmentasset);
+
+	PendingProgram p;
+	p.vertexname = vertexasset;
+	p.fragmentname = fragmentasset;
+	p.cache = programCacheEnabled();
+	p.key = 0;
+	p.vertex = p.fragment = 0;
+	if(p.cache)
+	{
+		p.key = programKey(vertexsource.c_str(), fragmentsource.c_str());
+		GLuint cached = loadProgramBinary(p.key);
+		if(cached)
+			return cached;
+	}
+
+	// no status is asked for here: that would wait for each compile in turn
+	p.vertex = submitShader(GL_VERTEX_SHADER, vertexasset, vertexsource);
+	p.fragment = submitShader(GL_FRAGMENT_SHADER, fragmentasset, fragmentsource);
+	p.program = glCreateProgram();
+	if(p.cache)
+		glProgramParameteri(p.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(p.program, p.vertex);
+	glAttachShader(p.program, p.fragment);
+	glLinkProgram(p.program);
+	pending.push_back(p);
+	return p.program;
+}
+
+static void printShaderLog (GLuint shader, const std::string& name)
+{
+	GLint compiled = GL_FALSE, length = 0;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+	if(compiled && length <= 1)
+		return;
+	std::vector<char> log(length > 1 ? length : 1, '\0');
+	glGetShaderInfoLog(shader, log.size(), NULL, &log[0]);
+	fprintf(stdout, "%s: %s\n", name.c_str(), &log[0]);
+}
+
+bool finishProgram (GLuint program)
+{
+	TRACE_SCOPE("finishProgram");
+	size_t i;
+	for(i=0; i<pending.size(); i++)
+		if(pending[i].program == program)
+			break;
+	if(i == pending.size())
+		return true;     // from the cache, or finished before
+	PendingProgram p = pending[i];
+	pending.erase(pending.begin() + i);
+
+	GLint linked = GL_FALSE, length = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if(!linked)
+	{
+		printShaderLog(p.vertex, p.vertexname);
+		printShaderLog(p.fragment, p.fragmentname);
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+		std::vector<char> log(length > 1 ? length : 1, '\0');
+		glGetProgramInfoLog(program, log.size(), NULL, &log[0]);
+		fprintf(stdout, "Linking %s + %s failed: %s\n", p.vertexname.c_str(), p.fragmentname.c_str(), &log[0]);
+	}
+	else if(p.cache)
+		saveProgramBinary(p.key, program);
+
+	glDetachShader(program, p.vertex);
+	glDetachShader(program, p.fragment);
+	glDeleteShader(p.vertex);
+	glDeleteShader(p.fragment);
+	return linked;
+}
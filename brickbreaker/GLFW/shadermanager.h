@@ -0,0 +1,24 @@
+#ifndef SHADERMANAGER_H
+#define SHADERMANAGER_H
+
+#include <glad/glad.h>
+
+/* Shader programs are built in two steps so that the driver can work on all
+ * of them at once. submitProgram hands over the sources, starts the compile
+ * and link and returns straight away; with ARB_parallel_shader_compile that
+ * work runs on the driver's own threads. Nothing asks the driver how it went
+ * until finishProgram, which the code using a program calls right before its
+ * first use; a program still linking is only waited for then. Programs found
+ * in the binary cache (programcache.h) are ready at once. */
+
+void initShaderManager ();
+
+/* Starts building a program from two assets; the name is valid at once,
+ * but nothing may be queried or drawn with it before finishProgram */
+GLuint submitProgram (const char* vertexasset, const char* fragmentasset);
+
+/* Waits for the link if needed, prints any errors and stores the binary in
+ * the cache. Costs nothing once a program is finished. False if it failed. */
+bool finishProgram (GLuint program);
+
+#endif
@@ -0,0 +1,176 @@
+#include <cstring>
+#include <cstddef>
+#include "spritebatch.h"
+#include "glstate.h"
+#include "camera.h"
+#include "shadermanager.h"
+#include "renderstats.h"
+
+#define SPRITE_REGION (SPRITE_MAX*sizeof(SpriteInstance))
+
+void initSpriteBatch (SpriteBatch* batch, GLuint program)
+{
+	static const GLfloat corners[] = {
+		0,0, 1,0, 1,1,
+		1,1, 0,1, 0,0
+	};
+
+	batch->program = program;
+	batch->linked = false;
+	batch->n = 0;
+	batch->nstates = 0;
+	batch->frame = 0;
+	batch->draws = 0;
+	for(int r=0; r<SPRITE_RING_FRAMES; r++)
+		batch->fence[r] = 0;
+
+	glGenVertexArrays(1, &batch->VertexArrayID);
+	glGenBuffers(1, &batch->QuadBuffer);
+	glGenBuffers(1, &batch->RingBuffer);
+	bindVertexArray(batch->VertexArrayID);
+
+	bindArrayBuffer(batch->QuadBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof corners, corners, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+	enableVertexAttrib(0);
+
+	bindArrayBuffer(batch->RingBuffer);
+	batch->persistent = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+	batch->mapped = NULL;
+	if(batch->persistent)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, SPRITE_RING_FRAMES*SPRITE_REGION, NULL, flags);
+		batch->mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, SPRITE_RING_FRAMES*SPRITE_REGION, flags);
+		batch->persistent = batch->mapped != NULL;
+	}
+	if(!batch->persistent)
+		glBufferData(GL_ARRAY_BUFFER, SPRITE_REGION, NULL, GL_STREAM_DRAW);
+
+	// attributes 1-3 advance once per sprite; their offsets are set at every flush
+	for(int a=1; a<=3; a++)
+	{
+		glVertexAttribDivisor(a, 1);
+		enableVertexAttrib(a);
+	}
+	bindVertexArray(0);
+}
+
+void pushSprite (SpriteBatch* batch, const SpriteInstance* sprite, int layer, GLenum fillmode)
+{
+	if(batch->n == SPRITE_MAX)
+		return;
+	int state;
+	for(state=0; state<batch->nstates; state++)
+		if(batch->fillmode[state] == fillmode)
+			break;
+	if(state == batch->nstates)
+	{
+		if(batch->nstates == SPRITE_STATES)
+			state = 0;
+		else
+			batch->fillmode[batch->nstates++] = fillmode;
+	}
+	if(layer < 0)
+		layer = 0;
+	if(layer >= SPRITE_LAYERS)
+		layer = SPRITE_LAYERS - 1;
+	batch->sprites[batch->n] = *sprite;
+	batch->key[batch->n] = layer*SPRITE_STATES + state;
+	batch->n++;
+}
+
+static void pointAttributes (size_t offset)
+{
+	GLsizei stride = sizeof(SpriteInstance);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(SpriteInstance, x)));
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(SpriteInstance, rect)));
+	glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(offset + offsetof(SpriteInstance, color)));
+}
+
+void flushSprites (SpriteBatch* batch)
+{
+	const int nkeys = SPRITE_LAYERS*SPRITE_STATES;
+	int start[SPRITE_LAYERS*SPRITE_STATES + 1];
+	int k, i;
+
+	batch->draws = 0;
+	if(batch->n == 0)
+		return;
+
+	// counting sort on the key; stable, so sprites of a layer keep their order
+	for(k=0; k<=nkeys; k++)
+		start[k] = 0;
+	for(i=0; i<batch->n; i++)
+		start[batch->key[i] + 1]++;
+	for(k=0; k<nkeys; k++)
+		start[k+1] += start[k];
+
+	int region = batch->frame % SPRITE_RING_FRAMES;
+	SpriteInstance* dst = batch->sorted;
+	if(batch->persistent)
+	{
+		// wait until the GPU is done with what this region held three frames ago
+		if(batch->fence[region])
+		{
+			while(glClientWaitSync(batch->fence[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+				;
+			glDeleteSync(batch->fence[region]);
+			batch->fence[region] = 0;
+		}
+		dst = (SpriteInstance*)(batch->mapped + region*SPRITE_REGION);
+	}
+	int next[SPRITE_LAYERS*SPRITE_STATES];
+	memcpy(next, start, sizeof next);
+	for(i=0; i<batch->n; i++)
+		dst[next[batch->key[i]]++] = batch->sprites[i];
+	countUpload(batch->n*sizeof(SpriteInstance));
+
+	bindVertexArray(batch->VertexArrayID);
+	bindArrayBuffer(batch->RingBuffer);
+	size_t base = 0;
+	if(batch->persistent)
+		base = region*SPRITE_REGION;
+	else
+	{
+		glBufferData(GL_ARRAY_BUFFER, SPRITE_REGION, NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, batch->n*sizeof(SpriteInstance), dst);
+	}
+
+	if(!batch->linked)
+	{
+		finishProgram(batch->program);
+		useCameraBlock(batch->program);
+		batch->linked = true;
+	}
+	useProgram(batch->program);
+
+	// one draw per run of sprites in the same state, across layer boundaries
+	int first = 0;
+	while(first < batch->n)
+	{
+		int state = -1, last = first;
+		for(k=0; k<nkeys; k++)
+		{
+			if(start[k] == start[k+1] || start[k+1] <= first)
+				continue;
+			if(state < 0)
+				state = k % SPRITE_STATES;
+			else if(k % SPRITE_STATES != state)
+				break;
+			last = start[k+1];
+		}
+		polygonMode(batch->fillmode[state]);
+		pointAttributes(base + first*sizeof(SpriteInstance));
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 6, last - first);
+		countDraw(6, last - first);
+		batch->draws++;
+		first = last;
+	}
+
+	if(batch->persistent)
+		batch->fence[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	batch->frame++;
+	batch->n = 0;
+	batch->nstates = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include <glad/glad.h>
+
+/* Sprite batcher.
+ * Every rectangle of a frame is pushed as one instance record and the whole
+ * frame is drawn at flush time with one instanced draw per run of sprites
+ * sharing the same state. Records go into one big streaming buffer used as a
+ * ring of SPRITE_RING_FRAMES regions: with ARB_buffer_storage it stays mapped
+ * and a fence per region keeps the CPU from overwriting a region the GPU is
+ * still reading, otherwise the buffer is orphaned every frame. */
+
+#define SPRITE_MAX 8192          // sprites per frame, enough for a full brick pool
+#define SPRITE_RING_FRAMES 3
+#define SPRITE_LAYERS 4          // lower layers are drawn first
+#define SPRITE_STATES 4          // distinct fill modes per frame
+
+struct SpriteInstance {
+	GLfloat x, y;            // where the local origin is placed
+	GLfloat rotation;        // radians, about the local origin
+	GLfloat depth;
+	GLfloat rect[4];         // min x, min y, max x, max y in local space
+	GLubyte color[4];
+};
+
+struct SpriteBatch {
+	GLuint program;
+	bool linked;             // set up on the first flush, see shadermanager.h
+	GLuint VertexArrayID;
+	GLuint QuadBuffer;       // the six corners of a unit quad
+	GLuint RingBuffer;
+
+	bool persistent;
+	unsigned char* mapped;   // whole ring when persistent
+	GLsync fence[SPRITE_RING_FRAMES];
+	int frame;
+
+	int n;
+	SpriteInstance sprites[SPRITE_MAX];
+	unsigned char key[SPRITE_MAX];           // layer*SPRITE_STATES + state
+	SpriteInstance sorted[SPRITE_MAX];       // staging for the orphaning path
+	GLenum fillmode[SPRITE_STATES];
+	int nstates;
+
+	int draws;               // draw calls of the last flush
+};
+
+void initSpriteBatch (SpriteBatch* batch, GLuint program);
+void pushSprite (SpriteBatch* batch, const SpriteInstance* sprite, int layer, GLenum fillmode);
+
+/* Draws everything pushed since the last flush, through the camera block */
+void flushSprites (SpriteBatch* batch);
+
+#endif
@@ -0,0 +1,287 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include "game.h"
+
+/* Difficulty sweep: plays many games headless with a simple bot for every
+ * combination of the tunables given on the command line and prints the
+ * score and survival distribution of each combination.
+ *
+ *   ./sweep --games 10000 --speedupper 0.04:0.10:0.02 --lanes 2:4:1
+ *
+ * A range is from:to:step, a single number sweeps just that value. */
+
+struct Range {
+	double from, to, step;
+};
+
+struct Combo {
+	float speedlower, speedupper;
+	int lanes;
+	float basketx, baskety;
+	double cooldown;
+};
+
+struct Result {
+	long long int points;
+	double survival;   // seconds until game over, or the whole game
+	int over;
+};
+
+static int ngames = 1000;
+static int nticks = 3600;          // one minute of play
+static unsigned int baseseed = 1;
+static std::vector<Combo> combos;
+static std::vector<Result> results;
+static std::atomic<int> nextjob;
+static BrickScript levelscript;
+static int scripted = 0;
+
+static int parseRange (const char* s, Range* r)
+{
+	r->step = 0;
+	int n = sscanf(s, "%lf:%lf:%lf", &r->from, &r->to, &r->step);
+	if(n < 1)
+		return 0;
+	if(n == 1)
+		r->to = r->from;
+	if(r->step <= 0)
+		r->step = r->to - r->from > 0 ? r->to - r->from : 1;
+	return 1;
+}
+
+/* Values of a range, the end included despite rounding */
+static std::vector<double> rangeValues (const Range& r)
+{
+	std::vector<double> v;
+	for(int k=0; r.from + k*r.step <= r.to + r.step*1e-6; k++)
+		v.push_back(r.from + k*r.step);
+	return v;
+}
+
+/* Lowest falling brick of a type, or -1 */
+static int lowestBrick (const BrickPool* bricks, int type)
+{
+	int best = -1;
+	for(int i=0; i<bricks->count; i++)
+	{
+		if(bricks->type[i] != type || bricks->basket[i] >= 0 || bricks->y[i] > 8)
+			continue;
+		if(best < 0 || bricks->y[i] < bricks->y[best])
+			best = i;
+	}
+	return best;
+}
+
+/* Moves a box under its colour, out from under a black brick about to land */
+static void steerBox (GameState* g, float boxx, int type, void (*left)(GameState*), void (*right)(GameState*))
+{
+	const BrickPool* bricks = &g->bricks;
+	float reach = g->collectingbox_xlength + brick_xlength;
+	for(int i=0; i<bricks->count; i++)
+	{
+		if(bricks->type[i] != BRICK_BLACK || bricks->y[i] > -3 || fabs(bricks->x[i] - boxx) > reach + 0.2)
+			continue;
+		if(bricks->x[i] > boxx)
+			left(g);
+		else
+			right(g);
+		return;
+	}
+	int i = lowestBrick(bricks, type);
+	if(i < 0)
+		return;
+	if(bricks->x[i] < boxx - 0.15)
+		left(g);
+	else if(bricks->x[i] > boxx + 0.15)
+		right(g);
+}
+
+/* Keeps the barrel level, lines the cannon up with where the lowest black
+ * brick will be when the shot gets there and fires */
+static void steerCannon (GameState* g)
+{
+	if(g->laser2_rotation > 1.5)
+		rotatecannonright(g);
+	else if(g->laser2_rotation < -1.5)
+		rotatecannonleft(g);
+
+	int i = lowestBrick(&g->bricks, BRICK_BLACK);
+	if(i < 0)
+		return;
+	float ticks = (g->bricks.x[i] - g->laser1_x) / 0.5;
+	float target = g->bricks.y[i] - g->bricks.speed[i]*ticks;
+	if(target > g->laser1_y + 0.1)
+		movecannonup(g);
+	else if(target < g->laser1_y - 0.1)
+		movecannondown(g);
+	else if(!g->laserflag)
+		fireLaser(g);
+}
+
+static void playGame (GameState* g, const Combo& c, unsigned int seed, Result* r)
+{
+	initGame(g, seed);
+	setLanes(g, c.lanes);
+	g->speedlower = c.speedlower;
+	g->speedupper = c.speedupper;
+	g->collectingbox_xlength = c.basketx;
+	g->collectingbox_ylength = c.baskety;
+	g->firecooldown = c.cooldown;
+	if(scripted)
+		attachBrickScript(&g->vm, &levelscript, seed);
+
+	int t;
+	for(t=0; t<nticks && !g->gameflag; t++)
+	{
+		steerBox(g, g->redbox_x, BRICK_RED, moveRedBoxleft, moveRedBoxright);
+		steerBox(g, g->greenbox_x, BRICK_GREEN, moveGreenBoxleft, moveGreenBoxright);
+		steerCannon(g);
+		stepGame(g);
+	}
+	r->points = g->points;
+	r->survival = t*GAME_TICK;
+	r->over = g->gameflag;
+}
+
+static void worker ()
+{
+	// a GameState is too big for a thread stack
+	GameState* g = new GameState;
+	int njobs = combos.size()*ngames;
+	for(int job = nextjob++; job < njobs; job = nextjob++)
+		playGame(g, combos[job/ngames], baseseed + 2654435761u*(unsigned int)job, &results[job]);
+	delete g;
+}
+
+static double percentile (const std::vector<double>& sorted, double p)
+{
+	int k = (int)(p*(sorted.size()-1) + 0.5);
+	return sorted[k];
+}
+
+static void usage ()
+{
+	fprintf(stderr, "usage: sweep [--games N] [--ticks T] [--threads K] [--seed S] [--script FILE] [--csv]\n"
+			"             [--speedlower R] [--speedupper R] [--lanes R]\n"
+			"             [--basketx R] [--baskety R] [--cooldown R]\n"
+			"R is from:to:step or a single value; lanes go from 1 to %d\n", MAX_LANES);
+	exit(1);
+}
+
+int main (int argc, char** argv)
+{
+	Range speedlower = {0.03, 0.03, 1}, speedupper = {0.06, 0.06, 1}, lanes = {3, 3, 1};
+	Range basketx = {0.5, 0.5, 1}, baskety = {0.75, 0.75, 1}, cooldown = {0.7, 0.7, 1};
+	int nthreads = std::thread::hardware_concurrency();
+	int csv = 0;
+	int i;
+
+	for(i=1; i<argc; i++)
+	{
+		const char* arg = argv[i];
+		if(!strcmp(arg, "--csv"))
+		{
+			csv = 1;
+			continue;
+		}
+		if(i+1 >= argc)
+			usage();
+		const char* val = argv[++i];
+		if(!strcmp(arg, "--games"))
+			ngames = atoi(val);
+		else if(!strcmp(arg, "--ticks"))
+			nticks = atoi(val);
+		else if(!strcmp(arg, "--threads"))
+			nthreads = atoi(val);
+		else if(!strcmp(arg, "--seed"))
+			baseseed = strtoul(val, NULL, 0);
+		else if(!strcmp(arg, "--script"))
+		{
+			if(!loadBrickScript(val, &levelscript))
+				return 1;
+			scripted = 1;
+		}
+		else if(!strcmp(arg, "--speedlower") && parseRange(val, &speedlower));
+		else if(!strcmp(arg, "--speedupper") && parseRange(val, &speedupper));
+		else if(!strcmp(arg, "--lanes") && parseRange(val, &lanes));
+		else if(!strcmp(arg, "--basketx") && parseRange(val, &basketx));
+		else if(!strcmp(arg, "--baskety") && parseRange(val, &baskety));
+		else if(!strcmp(arg, "--cooldown") && parseRange(val, &cooldown));
+		else
+			usage();
+	}
+	// the game would quietly clamp these, and the table would say otherwise
+	if(lanes.from < 1 || lanes.to > MAX_LANES)
+		usage();
+	if(ngames < 1)
+		ngames = 1;
+	if(nthreads < 1)
+		nthreads = 1;
+
+	std::vector<double> sl = rangeValues(speedlower), su = rangeValues(speedupper), ln = rangeValues(lanes);
+	std::vector<double> bx = rangeValues(basketx), by = rangeValues(baskety), cd = rangeValues(cooldown);
+	for(size_t a=0; a<sl.size(); a++)
+	for(size_t b=0; b<su.size(); b++)
+	for(size_t c=0; c<ln.size(); c++)
+	for(size_t d=0; d<bx.size(); d++)
+	for(size_t e=0; e<by.size(); e++)
+	for(size_t f=0; f<cd.size(); f++)
+	{
+		Combo combo;
+		combo.speedlower = sl[a];
+		combo.speedupper = su[b];
+		combo.lanes = (int)(ln[c] + 0.5);
+		combo.basketx = bx[d];
+		combo.baskety = by[e];
+		combo.cooldown = cd[f];
+		combos.push_back(combo);
+	}
+	results.resize(combos.size()*ngames);
+
+	fprintf(stderr, "sweep: %d combinations x %d games on %d threads\n", (int)combos.size(), ngames, nthreads);
+	std::vector<std::thread> threads;
+	for(i=0; i<nthreads; i++)
+		threads.push_back(std::thread(worker));
+	for(i=0; i<nthreads; i++)
+		threads[i].join();
+
+	if(csv)
+		printf("speedlower,speedupper,lanes,basketx,baskety,cooldown,score_mean,score_p10,score_p50,score_p90,"
+				"survival_mean,survival_p10,survival_p50,survival_p90,gameover\n");
+	else
+		printf("%-7s %-7s %-5s %-5s %-5s %-5s | %8s %6s %6s %6s | %7s %6s %6s %6s | %5s\n",
+				"slower", "supper", "lanes", "boxx", "boxy", "cool",
+				"score", "p10", "p50", "p90", "alive s", "p10", "p50", "p90", "over%");
+
+	for(size_t k=0; k<combos.size(); k++)
+	{
+		std::vector<double> score(ngames), alive(ngames);
+		double scoresum = 0, alivesum = 0;
+		int over = 0;
+		for(i=0; i<ngames; i++)
+		{
+			const Result& r = results[k*ngames + i];
+			score[i] = r.points;
+			alive[i] = r.survival;
+			scoresum += r.points;
+			alivesum += r.survival;
+			over += r.over;
+		}
+		std::sort(score.begin(), score.end());
+		std::sort(alive.begin(), alive.end());
+		const Combo& c = combos[k];
+		printf(csv ? "%g,%g,%d,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g\n"
+				: "%-7.3f %-7.3f %-5d %-5.2f %-5.2f %-5.2f | %8.1f %6.0f %6.0f %6.0f | %7.1f %6.1f %6.1f %6.1f | %5.1f\n",
+				c.speedlower, c.speedupper, c.lanes, c.basketx, c.baskety, c.cooldown,
+				scoresum/ngames, percentile(score, 0.1), percentile(score, 0.5), percentile(score, 0.9),
+				alivesum/ngames, percentile(alive, 0.1), percentile(alive, 0.5), percentile(alive, 0.9),
+				100.0*over/ngames);
+	}
+	return 0;
+}
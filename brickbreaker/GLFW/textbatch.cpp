@@ -0,0 +1,234 @@
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include "textbatch.h"
+#include "glstate.h"
+#include "shadermanager.h"
+#include "renderstats.h"
+
+/* Font units: a capital is 4 wide and 6 high, the pen moves 5 per character.
+ * The atlas has TEXEL_UNIT texels per unit and a cell per character with the
+ * glyph origin PAD_X, PAD_Y texels in, so the distance field has room to fade. */
+#define TEXEL_UNIT 6
+#define CELL_W 32
+#define CELL_H 48
+#define PAD_X 4
+#define PAD_Y 6
+#define GLYPH_HEIGHT 6.0f
+#define GLYPH_ADVANCE 5.0f
+#define STROKE_HALFWIDTH 0.45f   // units
+#define FIELD_SPREAD 1.0f        // units from the edge to a texel of 0 or 1
+
+/* The stroke font. Each glyph is a list of polylines separated by spaces;
+ * a polyline is a run of points, each point an x digit (0-4) followed by a
+ * y digit (0-6). A polyline of one repeated point is a dot. */
+static const struct {
+	char c;
+	const char* strokes;
+} strokefont[] = {
+	{'0', "0040460600 0046"}, {'1', "152620 1030"}, {'2', "05163645440040"},
+	{'3', "06464000 1343"}, {'4', "30360242"}, {'5', "460603434000"},
+	{'6', "460600404303"}, {'7', "064610"}, {'8', "0040460600 0343"},
+	{'9', "430306464000"},
+	{'A', "0004264440 0343"}, {'B', "00063645443303 3342413000"}, {'C', "46060040"},
+	{'D', "00062644422000"}, {'E', "46060040 0333"}, {'F', "460600 0333"},
+	{'G', "45460600404323"}, {'H', "0006 4046 0343"}, {'I', "0646 2620 0040"},
+	{'J', "164641301001"}, {'K', "0006 4602 1340"}, {'L', "060040"},
+	{'M', "0006234640"}, {'N', "00064046"}, {'O', "0040460600"},
+	{'P', "0006464303"}, {'Q', "0040460600 2240"}, {'R', "0006464303 1340"},
+	{'S', "45361605044241301001"}, {'T', "0646 2620"}, {'U', "06004046"},
+	{'V', "062046"}, {'W', "0610233046"}, {'X', "0046 0640"},
+	{'Y', "062346 2320"}, {'Z', "06460040"},
+	{'.', "2020"}, {',', "2110"}, {':', "2121 2525"}, {';', "2525 2110"},
+	{'-', "1333"}, {'+', "1333 2224"}, {'=', "0242 0444"}, {'_', "0040"},
+	{'/', "0046"}, {'%', "0046 0505 4141"}, {'(', "36252130"}, {')', "16252110"},
+	{'[', "36161030"}, {']', "16363010"}, {'<', "450341"}, {'>', "054301"},
+	{'!', "2622 2020"}, {'?', "05163645442322 2020"}, {'\'', "2625"}, {'"', "1615 3635"},
+	{'|', "2026"}, {'*', "1531 1135 0343"},
+};
+
+static float segmentDistance (float px, float py, float ax, float ay, float bx, float by)
+{
+	float dx = bx - ax, dy = by - ay;
+	float len2 = dx*dx + dy*dy;
+	float t = len2 > 0 ? ((px - ax)*dx + (py - ay)*dy) / len2 : 0;
+	if(t < 0)
+		t = 0;
+	if(t > 1)
+		t = 1;
+	float ex = px - (ax + t*dx), ey = py - (ay + t*dy);
+	return sqrtf(ex*ex + ey*ey);
+}
+
+/* Fills the cell of one glyph: 0.5 on the stroke edge, rising inside */
+static void bakeGlyph (unsigned char* atlas, int cellx, int celly, const char* strokes)
+{
+	// split the polylines into segments
+	std::vector<float> seg;
+	for(const char* s = strokes; *s; )
+	{
+		if(*s == ' ')
+		{
+			s++;
+			continue;
+		}
+		float lastx = s[0] - '0', lasty = s[1] - '0';
+		s += 2;
+		if(*s == '\0' || *s == ' ')
+		{
+			float dot[4] = {lastx, lasty, lastx, lasty};
+			seg.insert(seg.end(), dot, dot + 4);
+		}
+		while(*s && *s != ' ')
+		{
+			float x = s[0] - '0', y = s[1] - '0';
+			float line[4] = {lastx, lasty, x, y};
+			seg.insert(seg.end(), line, line + 4);
+			lastx = x;
+			lasty = y;
+			s += 2;
+		}
+	}
+
+	int width = TEXT_ATLAS_COLUMNS*CELL_W;
+	for(int ty=0; ty<CELL_H; ty++)
+	for(int tx=0; tx<CELL_W; tx++)
+	{
+		float px = (tx + 0.5f - PAD_X) / TEXEL_UNIT, py = (ty + 0.5f - PAD_Y) / TEXEL_UNIT;
+		float d = 1e9f;
+		for(size_t k=0; k<seg.size(); k+=4)
+			d = fminf(d, segmentDistance(px, py, seg[k], seg[k+1], seg[k+2], seg[k+3]));
+		float v = 0.5f - 0.5f*(d - STROKE_HALFWIDTH)/FIELD_SPREAD;
+		v = fminf(fmaxf(v, 0.0f), 1.0f);
+		atlas[(celly*CELL_H + ty)*width + cellx*CELL_W + tx] = (unsigned char)(v*255 + 0.5f);
+	}
+}
+
+void initTextBatch (TextBatch* batch, GLuint program)
+{
+	batch->program = program;
+	batch->linked = false;
+	batch->n = 0;
+	batch->draws = 0;
+
+	int width = TEXT_ATLAS_COLUMNS*CELL_W, height = TEXT_ATLAS_ROWS*CELL_H;
+	std::vector<unsigned char> atlas(width*height, 0);
+	for(size_t i=0; i<sizeof strokefont/sizeof strokefont[0]; i++)
+	{
+		int k = strokefont[i].c - 32;
+		bakeGlyph(&atlas[0], k % TEXT_ATLAS_COLUMNS, k / TEXT_ATLAS_COLUMNS, strokefont[i].strokes);
+	}
+
+	glGenTextures(1, &batch->Atlas);
+	bindTexture2D(batch->Atlas);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, &atlas[0]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	// no mipmaps: averaging a distance field blurs the edge instead of shrinking it
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenVertexArrays(1, &batch->VertexArrayID);
+	glGenBuffers(1, &batch->InstanceBuffer);
+	bindVertexArray(batch->VertexArrayID);
+	bindArrayBuffer(batch->InstanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof batch->glyphs, NULL, GL_STREAM_DRAW);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextGlyph), (void*)offsetof(TextGlyph, x));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TextGlyph), (void*)offsetof(TextGlyph, color));
+	glVertexAttribDivisor(0, 1);
+	glVertexAttribDivisor(1, 1);
+	enableVertexAttrib(0);
+	enableVertexAttrib(1);
+	bindVertexArray(0);
+}
+
+float pushText (TextBatch* batch, float x, float y, float size, const char* text, const GLubyte color[4])
+{
+	float advance = size*GLYPH_ADVANCE/GLYPH_HEIGHT;
+	float left = x;
+	for(const char* s = text; *s; s++)
+	{
+		int c = (unsigned char)*s;
+		if(c == '\n')
+		{
+			x = left;
+			y -= 1.75f*size;
+			continue;
+		}
+		if(c >= 'a' && c <= 'z')
+			c += 'A' - 'a';
+		if(c > 32 && c < 128 && batch->n < TEXT_MAX_GLYPHS)
+		{
+			TextGlyph* g = &batch->glyphs[batch->n++];
+			g->x = x;
+			g->y = y;
+			g->size = size;
+			g->code = c;
+			for(int k=0; k<4; k++)
+				g->color[k] = color[k];
+		}
+		x += advance;
+	}
+	return x;
+}
+
+float textWidth (const char* text, float size)
+{
+	int n = 0;
+	while(text[n] && text[n] != '\n')
+		n++;
+	return n*size*GLYPH_ADVANCE/GLYPH_HEIGHT;
+}
+
+/* First use of the program: wait for it and set the uniforms that never change */
+static void linkTextProgram (TextBatch* batch)
+{
+	GLuint program = batch->program;
+	finishProgram(program);
+	batch->VPID = glGetUniformLocation(program, "VP");
+
+	// where a cell lies around the glyph origin, in capital heights
+	useProgram(program);
+	glUniform1i(glGetUniformLocation(program, "Atlas"), 0);
+	glUniform4f(glGetUniformLocation(program, "CellBox"),
+			-PAD_X/(TEXEL_UNIT*GLYPH_HEIGHT), -PAD_Y/(TEXEL_UNIT*GLYPH_HEIGHT),
+			(CELL_W - PAD_X)/(TEXEL_UNIT*GLYPH_HEIGHT), (CELL_H - PAD_Y)/(TEXEL_UNIT*GLYPH_HEIGHT));
+	glUniform2f(glGetUniformLocation(program, "AtlasGrid"), TEXT_ATLAS_COLUMNS, TEXT_ATLAS_ROWS);
+	batch->linked = true;
+}
+
+void flushText (TextBatch* batch, const GLfloat* VP)
+{
+	batch->draws = 0;
+	if(batch->n == 0)
+		return;
+
+	bindArrayBuffer(batch->InstanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof batch->glyphs, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, batch->n*sizeof(TextGlyph), batch->glyphs);
+	countUpload(batch->n*sizeof(TextGlyph));
+
+	bool depth = capabilityEnabled(GL_DEPTH_TEST);
+	setCapability(GL_DEPTH_TEST, false);
+	setCapability(GL_BLEND, true);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	polygonMode(GL_FILL);
+
+	if(!batch->linked)
+		linkTextProgram(batch);
+	useProgram(batch->program);
+	glUniformMatrix4fv(batch->VPID, 1, GL_FALSE, VP);
+	countStat(STAT_UNIFORMS);
+	bindTexture2D(batch->Atlas);
+	bindVertexArray(batch->VertexArrayID);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, batch->n);
+	countDraw(6, batch->n);
+	batch->draws = 1;
+
+	setCapability(GL_BLEND, false);
+	if(depth)
+		setCapability(GL_DEPTH_TEST, true);
+	batch->n = 0;
+}
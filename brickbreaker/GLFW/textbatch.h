@@ -0,0 +1,50 @@
+#ifndef TEXTBATCH_H
+#define TEXTBATCH_H
+
+#include <glad/glad.h>
+
+/* Text drawn from a signed distance field glyph atlas.
+ * The atlas is baked once at start up from a small built in stroke font:
+ * every texel holds the distance to the nearest stroke, so the fragment
+ * shader can cut a sharp edge at any scale. Each character becomes one
+ * instance and everything pushed between two flushes is drawn with a single
+ * instanced draw. Lower case letters are drawn as capitals; characters the
+ * font does not have come out blank. */
+
+#define TEXT_MAX_GLYPHS 4096      // characters per flush
+#define TEXT_ATLAS_COLUMNS 16     // the atlas holds ASCII 32-127, 16 to a row
+#define TEXT_ATLAS_ROWS 6
+
+struct TextGlyph {
+	GLfloat x, y;             // left end of the baseline
+	GLfloat size;             // height of a capital
+	GLfloat code;             // the character
+	GLubyte color[4];
+};
+
+struct TextBatch {
+	GLuint program;
+	bool linked;              // set up on the first flush, see shadermanager.h
+	GLint VPID;
+	GLuint VertexArrayID;
+	GLuint InstanceBuffer;
+	GLuint Atlas;
+
+	int n;
+	TextGlyph glyphs[TEXT_MAX_GLYPHS];
+	int draws;                // draw calls of the last flush
+};
+
+void initTextBatch (TextBatch* batch, GLuint program);
+
+/* Queues text with the baseline starting at x, y; '\n' starts a new line.
+ * Returns the x where the next character would go. */
+float pushText (TextBatch* batch, float x, float y, float size, const char* text, const GLubyte color[4]);
+
+/* Width of text on one line at the given size */
+float textWidth (const char* text, float size);
+
+/* Draws everything pushed since the last flush, blended and on top */
+void flushText (TextBatch* batch, const GLfloat* VP);
+
+#endif
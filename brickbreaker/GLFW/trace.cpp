@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <chrono>
+#include <mutex>
+#include "trace.h"
+
+bool traceon = false;
+static const char* tracepath;
+static double tracestart;
+
+// buffers[0 .. nbuffers-1] are published; lock only guards adding one
+static TraceBuffer* buffers[TRACE_THREADS];
+static std::atomic<int> nbuffers(0);
+static std::mutex lock;
+static thread_local TraceBuffer* mine;
+static thread_local bool full;     // no buffer left for this thread
+
+double traceClock ()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void startTrace (const char* path)
+{
+	tracepath = path;
+	tracestart = traceClock();
+	traceon = true;
+}
+
+static TraceBuffer* threadBuffer (const char* name)
+{
+	if(mine || full)
+		return mine;
+	std::lock_guard<std::mutex> hold(lock);
+	int n = nbuffers.load(std::memory_order_relaxed);
+	if(n == TRACE_THREADS)
+	{
+		full = true;
+		return NULL;
+	}
+	mine = new TraceBuffer;
+	mine->thread = name;
+	mine->count.store(0, std::memory_order_relaxed);
+	mine->dropped.store(0, std::memory_order_relaxed);
+	buffers[n] = mine;
+	nbuffers.store(n + 1, std::memory_order_release);
+	return mine;
+}
+
+void nameTraceThread (const char* name)
+{
+	if(traceon)
+		threadBuffer(name);
+}
+
+void traceEvent (const char* name, double start, double end)
+{
+	TraceBuffer* buffer = threadBuffer(NULL);
+	if(!buffer)
+		return;
+	int n = buffer->count.load(std::memory_order_relaxed);
+	if(n == TRACE_EVENTS)
+	{
+		buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	TraceEvent* event = &buffer->events[n];
+	event->name = name;
+	event->start = start;
+	event->end = end;
+	buffer->count.store(n + 1, std::memory_order_release);
+}
+
+bool writeTrace ()
+{
+	if(!traceon)
+		return false;
+	FILE* out = fopen(tracepath, "w");
+	if(!out)
+	{
+		fprintf(stderr, "Trace: can't write %s\n", tracepath);
+		return false;
+	}
+
+	// times in microseconds from startTrace, as the format wants
+	int nthreads = nbuffers.load(std::memory_order_acquire), nevents = 0, dropped = 0;
+	fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"brickbreaker\"}}");
+	for(int t=0; t<nthreads; t++)
+	{
+		TraceBuffer* buffer = buffers[t];
+		if(buffer->thread)
+			fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				t + 1, buffer->thread);
+		int n = buffer->count.load(std::memory_order_acquire);
+		for(int i=0; i<n; i++)
+		{
+			const TraceEvent* event = &buffer->events[i];
+			fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				event->name, t + 1, (event->start - tracestart)*1e6, (event->end - event->start)*1e6);
+		}
+		nevents += n;
+		dropped += buffer->dropped.load(std::memory_order_relaxed);
+	}
+	fprintf(out, "\n]}\n");
+	bool ok = !ferror(out);
+	if(fclose(out) != 0)
+		ok = false;
+	if(ok)
+		printf("Trace: %d events from %d threads to %s, %d dropped\n", nevents, nthreads, tracepath, dropped);
+	else
+		fprintf(stderr, "Trace: writing %s failed\n", tracepath);
+	return ok;
+}
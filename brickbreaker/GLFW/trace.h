@@ -0,0 +1,57 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+
+/* Timeline of what every thread was doing, written as Chrome trace JSON
+ * for chrome://tracing or ui.perfetto.dev.
+ * TRACE_SCOPE("name") records an event from there to the end of the block.
+ * Each thread has a buffer of its own, so recording takes no lock: the event
+ * is filled in, then published by bumping the buffer's count, and the writer
+ * only reads events below the count. A full buffer drops further events.
+ * Until startTrace a scope costs one test of a flag. Names must be string
+ * literals, or live as long; they are not escaped. */
+
+#define TRACE_EVENTS 65536        // events kept per thread
+#define TRACE_THREADS 8           // threads that can record
+
+struct TraceEvent {
+	const char* name;
+	double start, end;            // seconds on the steady clock
+};
+
+struct TraceBuffer {
+	const char* thread;
+	TraceEvent events[TRACE_EVENTS];
+	std::atomic<int> count;
+	std::atomic<int> dropped;
+};
+
+extern bool traceon;
+
+/* Records from now on and sets where writeTrace writes; call before the
+ * other threads start */
+void startTrace (const char* path);
+
+/* Names the calling thread in the timeline; call before it records anything */
+void nameTraceThread (const char* name);
+
+double traceClock ();
+void traceEvent (const char* name, double start, double end);
+
+/* Writes everything recorded so far, replacing the file. Any thread may
+ * call it while the others go on recording. */
+bool writeTrace ();
+
+struct TraceScope {
+	const char* name;
+	double start;
+	TraceScope (const char* name) : name(name), start(traceon ? traceClock() : 0) {}
+	~TraceScope () { if(traceon) traceEvent(name, start, traceClock()); }
+};
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_JOIN(tracescope, __LINE__)(name)
+
+#endif